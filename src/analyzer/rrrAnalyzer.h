@@ -2,6 +2,8 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
 
 namespace rrr {
 
@@ -13,6 +15,7 @@ namespace rrr {
 
     // parameters
     bool nVerbose;
+    bool fMinimizeCore;
 
     // data
     Sim sim;
@@ -22,11 +25,21 @@ namespace rrr {
     // constructors
     Analyzer(Parameter const *pPar);
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop); // queries are given up once *pStop becomes nonzero
+    void SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys); // unused as no BDDs are built
+    void SetBddBase(BddBase *pBase); // unused as no BDDs are built
 
     // checks
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
 
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
     // summary
     void ResetSummary();
     summary<int> GetStatsSummary() const;
@@ -39,6 +52,7 @@ namespace rrr {
   Analyzer<Ntk, Sim, Sol>::Analyzer(Parameter const *pPar) :
     pNtk(NULL),
     nVerbose(pPar->nAnalyzerVerbose),
+    fMinimizeCore(pPar->fMinimizeCore),
     sim(pPar),
     sol(pPar) {
   }
@@ -50,6 +64,24 @@ namespace rrr {
     sol.AssignNetwork(pNtk, fReuse);
   }
 
+  template <typename Ntk, typename Sim, typename Sol>
+  void Analyzer<Ntk, Sim, Sol>::SetTimeBudget(time_point start, seconds nTimeout) {
+    sol.SetTimeBudget(start, nTimeout);
+  }
+
+  template <typename Ntk, typename Sim, typename Sol>
+  void Analyzer<Ntk, Sim, Sol>::SetStop(int *pStop) {
+    sol.SetStop(pStop);
+  }
+
+  template <typename Ntk, typename Sim, typename Sol>
+  void Analyzer<Ntk, Sim, Sol>::SetOrderTable(OrderTable *, std::vector<int> const &) {
+  }
+
+  template <typename Ntk, typename Sim, typename Sol>
+  void Analyzer<Ntk, Sim, Sol>::SetBddBase(BddBase *) {
+  }
+
   /* }}} */
 
   /* {{{ Checks */
@@ -78,6 +110,9 @@ namespace rrr {
           std::cout << "node " << id << " fanin " << (pNtk->GetCompl(id, idx)? "!": "") << pNtk->GetFanin(id, idx) << " index " << idx << " is NOT redundant" << std::endl;
         }
         sim.AddCex(sol.GetCex());
+        while(sol.HarvestCex()) {
+          sim.AddCex(sol.GetCex());
+        }
       }
     } else {
       // if(nVerbose) {
@@ -111,6 +146,9 @@ namespace rrr {
           std::cout << "node " << id << " fanin " << (c? "!": "") << fi << " is NOT feasible" << std::endl;
         }
         sim.AddCex(sol.GetCex());
+        while(sol.HarvestCex()) {
+          sim.AddCex(sol.GetCex());
+        }
       }
     } else {
       // if(nVerbose) {
@@ -122,6 +160,86 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Multiple removal */
+
+  template <typename Ntk, typename Sim, typename Sol>
+  bool Analyzer<Ntk, Sim, Sol>::GetRedundantFanins(int id, std::vector<int> &vIdxs) {
+    // fanins that are necessary by simulation are kept from the beginning
+    std::vector<int> vKeeps;
+    std::vector<bool> vNecessaries(pNtk->GetNumFanins(id));
+    for(int idx = 0; idx < pNtk->GetNumFanins(id); idx++) {
+      if(!sim.CheckRedundancy(id, idx)) {
+        vKeeps.push_back(idx);
+        vNecessaries[idx] = true;
+      }
+    }
+    if(int_size(vKeeps) == pNtk->GetNumFanins(id)) {
+      vIdxs.clear();
+      return true;
+    }
+    // extend kept fanins by cexes until the others are removable, which terminates as one is added each time
+    while(true) {
+      SatResult r = sol.CheckRedundantFanins(id, vKeeps);
+      if(r == UNDET) {
+        return false;
+      }
+      if(r == UNSAT) {
+        break;
+      }
+      sim.AddCex(sol.GetCex());
+      while(sol.HarvestCex()) {
+        sim.AddCex(sol.GetCex());
+      }
+    }
+    // optionally drop kept fanins one by one, where core may drop more
+    if(fMinimizeCore) {
+      for(int i = 0; i < int_size(vKeeps); i++) {
+        if(vNecessaries[vKeeps[i]]) {
+          continue;
+        }
+        std::vector<int> vKeeps2 = vKeeps;
+        vKeeps2.erase(vKeeps2.begin() + i);
+        SatResult r = sol.CheckRedundantFanins(id, vKeeps2);
+        if(r == UNSAT) {
+          vKeeps.swap(vKeeps2);
+          i = -1;
+          continue;
+        }
+        if(r == SAT) {
+          sim.AddCex(sol.GetCex());
+          while(sol.HarvestCex()) {
+            sim.AddCex(sol.GetCex());
+          }
+        }
+        vNecessaries[vKeeps[i]] = true;
+      }
+    }
+    vIdxs.clear();
+    for(int idx = 0, i = 0; idx < pNtk->GetNumFanins(id); idx++) {
+      if(i < int_size(vKeeps) && vKeeps[i] == idx) {
+        i++;
+      } else {
+        vIdxs.push_back(idx);
+      }
+    }
+    if(nVerbose) {
+      std::cout << "node " << id << " has " << int_size(vIdxs) << " fanins removable together out of " << pNtk->GetNumFanins(id) << std::endl;
+    }
+    return true;
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk, typename Sim, typename Sol>
+  bool Analyzer<Ntk, Sim, Sol>::GetCandidates(int id, std::vector<int> &vCands, bool fCompl) {
+    sim.GetCandidates(id, vCands, fCompl);
+    return true;
+  }
+
+  /* }}} */
+
   /* {{{ Summary */
   
   template <typename Ntk, typename Sim, typename Sol>
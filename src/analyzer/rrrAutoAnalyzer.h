@@ -0,0 +1,329 @@
+#pragma once
+
+#include "misc/rrrParameter.h"
+#include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
+#include "engine/rrrBddManager.h"
+
+namespace rrr {
+
+  // analyzer that picks truth tables, BDDs, or SAT for each assigned network
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  class AutoAnalyzer {
+  private:
+    // aliases
+    using lit = NewBdd::lit;
+    enum Engine {
+      ENGINE_TT,
+      ENGINE_BDD,
+      ENGINE_SAT,
+      ENGINE_NUM
+    };
+    static constexpr int nTtInputMax = 16; // truth tables of up to 1024 words
+    static constexpr int nBddNodeMax = 20000; // larger networks go to SAT without probing
+    static constexpr int nProbeObjsLog = 16; // BDD nodes allowed in probe
+
+    // pointer to network
+    Ntk *pNtk;
+
+    // parameters
+    int nVerbose;
+
+    // data
+    int *pStop;
+    TtAna tt;
+    BddAna bdd;
+    SatAna sat;
+    Engine engine;
+
+    // stats
+    int nAssigned[ENGINE_NUM];
+    int nProbes;
+    double durationProbe;
+
+    // selection
+    bool ProbeBdd();
+    Engine SelectEngine();
+
+  public:
+    // constructors
+    AutoAnalyzer(Parameter const *pPar);
+    void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop_); // queries are given up once *pStop becomes nonzero
+    void SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys);
+    void SetBddBase(BddBase *pBase);
+
+    // checks
+    bool CheckRedundancy(int id, int idx);
+    bool CheckFeasibility(int id, int fi, bool c);
+
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
+    // summary
+    void ResetSummary();
+    summary<int> GetStatsSummary() const;
+    summary<double> GetTimesSummary() const;
+  };
+
+  /* {{{ Selection */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  bool AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::ProbeBdd() {
+    // build functions of all nodes in small manager, which runs out of nodes unless BDDs stay compact
+    time_point timeStart = GetCurrentTime();
+    nProbes++;
+    NewBdd::Param Par;
+    Par.nObjsAllocLog = nProbeObjsLog - 4;
+    Par.nObjsMaxLog = nProbeObjsLog;
+    Par.nCacheSizeLog = nProbeObjsLog - 4;
+    Par.nCacheMaxLog = nProbeObjsLog;
+    NewBdd::Man *pBdd = new NewBdd::Man(pNtk->GetNumPis(), Par);
+    pBdd->SetStop(pStop);
+    std::vector<lit> vFs(pNtk->GetNumNodes());
+    vFs[0] = pBdd->Const0();
+    int idx = 0;
+    pNtk->ForEachPi([&](int id) {
+      vFs[id] = pBdd->IthVar(idx);
+      idx++;
+    });
+    bool fFit = true;
+    pNtk->ForEachInt([&](int id) {
+      if(!fFit) {
+        return;
+      }
+      lit x = pBdd->Const1();
+      pBdd->IncRef(x);
+      pNtk->ForEachFanin(id, [&](int fi, bool c) {
+        lit y = pBdd->And(x, pBdd->LitNotCond(vFs[fi], c));
+        pBdd->IncRef(y);
+        pBdd->DecRef(x);
+        x = y;
+      });
+      if(pBdd->LitIsInvalid(x)) {
+        fFit = false;
+      }
+      vFs[id] = x;
+    });
+    delete pBdd;
+    durationProbe += Duration(timeStart, GetCurrentTime());
+    return fFit;
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  typename AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::Engine AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::SelectEngine() {
+    if(pNtk->GetNumPis() <= nTtInputMax) {
+      return ENGINE_TT;
+    }
+    if(pNtk->GetNumInts() <= nBddNodeMax && pNtk->GetNumPis() < (1 << (nProbeObjsLog - 4)) && ProbeBdd()) {
+      return ENGINE_BDD;
+    }
+    return ENGINE_SAT;
+  }
+
+  /* }}} */
+
+  /* {{{ Constructors */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::AutoAnalyzer(Parameter const *pPar) :
+    pNtk(NULL),
+    nVerbose(pPar->nAnalyzerVerbose),
+    pStop(NULL),
+    tt(pPar),
+    bdd(pPar),
+    sat(pPar),
+    engine(ENGINE_SAT) {
+    ResetSummary();
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::AssignNetwork(Ntk *pNtk_, bool fReuse) {
+    // engines keep callbacks registered, so network being reused stays with same engine
+    bool fSelect = !fReuse || !pNtk;
+    pNtk = pNtk_;
+    if(fSelect) {
+      engine = SelectEngine();
+      if(nVerbose) {
+        std::cout << "network with " << pNtk->GetNumPis() << " inputs and " << pNtk->GetNumInts() << " nodes is analyzed by " << (engine == ENGINE_TT? "truth tables": engine == ENGINE_BDD? "BDDs": "SAT") << std::endl;
+      }
+    }
+    nAssigned[engine]++;
+    switch(engine) {
+    case ENGINE_TT:
+      tt.AssignNetwork(pNtk, fReuse);
+      break;
+    case ENGINE_BDD:
+      bdd.AssignNetwork(pNtk, fReuse);
+      break;
+    case ENGINE_SAT:
+      sat.AssignNetwork(pNtk, fReuse);
+      break;
+    default:
+      assert(0);
+    }
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::SetTimeBudget(time_point start, seconds nTimeout) {
+    tt.SetTimeBudget(start, nTimeout);
+    bdd.SetTimeBudget(start, nTimeout);
+    sat.SetTimeBudget(start, nTimeout);
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    tt.SetStop(pStop);
+    bdd.SetStop(pStop);
+    sat.SetStop(pStop);
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys) {
+    bdd.SetOrderTable(pOrders, vKeys);
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::SetBddBase(BddBase *pBase) {
+    bdd.SetBddBase(pBase);
+  }
+
+  /* }}} */
+
+  /* {{{ Checks */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  bool AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::CheckRedundancy(int id, int idx) {
+    switch(engine) {
+    case ENGINE_TT:
+      return tt.CheckRedundancy(id, idx);
+    case ENGINE_BDD:
+      return bdd.CheckRedundancy(id, idx);
+    case ENGINE_SAT:
+      return sat.CheckRedundancy(id, idx);
+    default:
+      assert(0);
+    }
+    return false;
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  bool AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::CheckFeasibility(int id, int fi, bool c) {
+    switch(engine) {
+    case ENGINE_TT:
+      return tt.CheckFeasibility(id, fi, c);
+    case ENGINE_BDD:
+      return bdd.CheckFeasibility(id, fi, c);
+    case ENGINE_SAT:
+      return sat.CheckFeasibility(id, fi, c);
+    default:
+      assert(0);
+    }
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Multiple removal */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  bool AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::GetRedundantFanins(int id, std::vector<int> &vIdxs) {
+    switch(engine) {
+    case ENGINE_TT:
+      return tt.GetRedundantFanins(id, vIdxs);
+    case ENGINE_BDD:
+      return bdd.GetRedundantFanins(id, vIdxs);
+    case ENGINE_SAT:
+      return sat.GetRedundantFanins(id, vIdxs);
+    default:
+      assert(0);
+    }
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  bool AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::GetCandidates(int id, std::vector<int> &vCands, bool fCompl) {
+    switch(engine) {
+    case ENGINE_TT:
+      return tt.GetCandidates(id, vCands, fCompl);
+    case ENGINE_BDD:
+      return bdd.GetCandidates(id, vCands, fCompl);
+    case ENGINE_SAT:
+      return sat.GetCandidates(id, vCands, fCompl);
+    default:
+      assert(0);
+    }
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Summary */
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  void AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::ResetSummary() {
+    tt.ResetSummary();
+    bdd.ResetSummary();
+    sat.ResetSummary();
+    for(int i = 0; i < ENGINE_NUM; i++) {
+      nAssigned[i] = 0;
+    }
+    nProbes = 0;
+    durationProbe = 0;
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  summary<int> AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::GetStatsSummary() const {
+    summary<int> v;
+    v.emplace_back("auto tt", nAssigned[ENGINE_TT]);
+    v.emplace_back("auto bdd", nAssigned[ENGINE_BDD]);
+    v.emplace_back("auto sat", nAssigned[ENGINE_SAT]);
+    v.emplace_back("auto bdd probe", nProbes);
+    // engines not used since reset are omitted
+    if(nAssigned[ENGINE_TT]) {
+      summary<int> v2 = tt.GetStatsSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    if(nAssigned[ENGINE_BDD]) {
+      summary<int> v2 = bdd.GetStatsSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    if(nAssigned[ENGINE_SAT]) {
+      summary<int> v2 = sat.GetStatsSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    return v;
+  }
+
+  template <typename Ntk, typename TtAna, typename BddAna, typename SatAna>
+  summary<double> AutoAnalyzer<Ntk, TtAna, BddAna, SatAna>::GetTimesSummary() const {
+    summary<double> v;
+    v.emplace_back("auto bdd probe", durationProbe);
+    if(nAssigned[ENGINE_TT]) {
+      summary<double> v2 = tt.GetTimesSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    if(nAssigned[ENGINE_BDD]) {
+      summary<double> v2 = bdd.GetTimesSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    if(nAssigned[ENGINE_SAT]) {
+      summary<double> v2 = sat.GetTimesSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    return v;
+  }
+
+  /* }}} */
+
+}
@@ -2,6 +2,9 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "extra/rrrSlab.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
 #include "engine/rrrBddManager.h"
 
 namespace rrr {
@@ -23,10 +26,15 @@ namespace rrr {
     // data
     bool fInitialized;
     NewBdd::Man *pBdd;
+    NewBdd::Man *pBddSpare; // manager of previous network, whose storage is reused
+    int *pStop;
+    OrderTable *pOrders;
+    BddBase *pBase;
+    std::vector<int> vOrderKeys; // identities of inputs in order table
     int target;
     std::vector<lit> vFs;
     std::vector<lit> vGs;
-    std::vector<std::vector<lit>> vvCs;
+    Slab<lit> vvCs; // carecubes of fanin edges
     bool fResim;
     std::vector<bool> vUpdates;
     std::vector<bool> vGUpdates;
@@ -34,10 +42,12 @@ namespace rrr {
 
     // backups
     std::vector<BddCspfAnalyzer> vBackups;
+    NewBdd::Man::Snapshot snapshot; // manager size when saved as backup
 
     // stats
     uint64_t nNodesOld;
     uint64_t nNodesAccumulated;
+    int nRestores;
     double durationSimulation;
     double durationPf;
     double durationCheck;
@@ -49,8 +59,9 @@ namespace rrr {
     void Assign(lit &x, lit y) const;
     void CopyVec(std::vector<lit> &x, std::vector<lit> const &y) const;
     void DelVec(std::vector<lit> &v) const;
-    void CopyVecVec(std::vector<std::vector<lit>> &x, std::vector<std::vector<lit>> const &y) const;
-    void DelVecVec(std::vector<std::vector<lit>> &v) const;
+    void CopySlab(Slab<lit> &x, Slab<lit> const &y) const;
+    void DelSlab(Slab<lit> &x, int id) const;
+    void DelSlab(Slab<lit> &x) const;
     lit  Xor(lit x, lit y) const;
 
     // callback
@@ -77,6 +88,7 @@ namespace rrr {
     void Save(int slot);
     void Load(int slot);
     void PopBack();
+    void Restore(int slot);
 
   public:
     // constructors
@@ -84,11 +96,22 @@ namespace rrr {
     BddCspfAnalyzer(Parameter const *pPar);
     ~BddCspfAnalyzer();
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop); // queries are given up once *pStop becomes nonzero
+    bool IsMemout() const; // nodes ran out, after which queries are given up
+    void SetOrderTable(OrderTable *pOrders_, std::vector<int> const &vKeys); // new managers start from order in table and export theirs
+    void SetBddBase(BddBase *pBase_); // new managers are copied from base, which first one builds
 
     // checks
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
 
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
     // summary
     void ResetSummary();
     summary<int> GetStatsSummary() const;
@@ -142,24 +165,32 @@ namespace rrr {
   }
 
   template <typename Ntk>
-  inline void BddCspfAnalyzer<Ntk>::CopyVecVec(std::vector<std::vector<lit>> &x, std::vector<std::vector<lit>> const &y) const {
-    for(size_t i = y.size(); i < x.size(); i++) {
-      DelVec(x[i]);
+  inline void BddCspfAnalyzer<Ntk>::CopySlab(Slab<lit> &x, Slab<lit> const &y) const {
+    for(lit a: y.GetData()) {
+      IncRef(a);
     }
-    x.resize(y.size());
-    for(size_t i = 0; i < y.size(); i++) {
-      CopyVec(x[i], y[i]);
+    for(lit a: x.GetData()) {
+      DecRef(a);
     }
+    x = y;
   }
 
   template <typename Ntk>
-  inline void BddCspfAnalyzer<Ntk>::DelVecVec(std::vector<std::vector<lit>> &v) const {
-    for(size_t i = 0; i < v.size(); i++) {
-      DelVec(v[i]);
+  inline void BddCspfAnalyzer<Ntk>::DelSlab(Slab<lit> &x, int id) const {
+    for(int idx = 0; idx < x.Size(id); idx++) {
+      DecRef(*x.Get(id, idx));
     }
-    v.clear();
+    x.Clear(id);
   }
-  
+
+  template <typename Ntk>
+  inline void BddCspfAnalyzer<Ntk>::DelSlab(Slab<lit> &x) const {
+    for(lit a: x.GetData()) {
+      DecRef(a);
+    }
+    x.Reset(1);
+  }
+
   template <typename Ntk>
   inline int BddCspfAnalyzer<Ntk>::Xor(lit x, lit y) const {
     lit f = pBdd->And(x, pBdd->LitNot(y));
@@ -178,13 +209,17 @@ namespace rrr {
 
   template <typename Ntk>
   void BddCspfAnalyzer<Ntk>::ActionCallback(Action const &action) {
+    if(IsMemout()) {
+      // network is left to another analyzer until reassigned
+      return;
+    }
     switch(action.type) {
     case REMOVE_FANIN:
       assert(fInitialized);
       vUpdates[action.id] = true;
       vGUpdates[action.fi] = true;
-      DecRef(vvCs[action.id][action.idx]);
-      vvCs[action.id].erase(vvCs[action.id].begin() + action.idx);
+      DecRef(*vvCs.Get(action.id, action.idx));
+      vvCs.Erase(action.id, action.idx);
       if(target != action.id) {
         // require resimulate before next fesibility check
         // (this is not mandatory if no pending updates are in TFI of new fanin, but we would rather update than checking every time)
@@ -200,7 +235,7 @@ namespace rrr {
         }
         Assign(vFs[action.id], LitMax);
         Assign(vGs[action.id], LitMax);
-        DelVec(vvCs[action.id]);
+        DelSlab(vvCs, action.id);
       }
       break;
     case REMOVE_BUFFER:
@@ -216,7 +251,7 @@ namespace rrr {
         }
         Assign(vFs[action.id], LitMax);
         Assign(vGs[action.id], LitMax);
-        DelVec(vvCs[action.id]);
+        DelSlab(vvCs, action.id);
       }
       break;
     case REMOVE_CONST:
@@ -232,7 +267,7 @@ namespace rrr {
         }
         Assign(vFs[action.id], LitMax);
         Assign(vGs[action.id], LitMax);
-        DelVec(vvCs[action.id]);
+        DelSlab(vvCs, action.id);
       }
       break;
     case ADD_FANIN:
@@ -240,22 +275,20 @@ namespace rrr {
       assert(fInitialized);
       vUpdates[action.id] = true;
       vCUpdates[action.id] = true;
-      vvCs[action.id].insert(vvCs[action.id].begin() + action.idx, LitMax);
+      vvCs.Insert(action.id, action.idx);
       break;
     case TRIVIAL_COLLAPSE:
       if(fInitialized) {
         if(vGUpdates[action.fi] || vCUpdates[action.fi]) {
           vCUpdates[action.id] = true;
         }
-        std::vector<lit>::iterator it = vvCs[action.id].begin() + action.idx;
-        DecRef(*it);
-        it = vvCs[action.id].erase(it);
-        for(int idx: action.vIndices) {
-          it = vvCs[action.id].insert(it,  vvCs[action.fi][idx]);
-          IncRef(*it);
-          it++;
+        DecRef(*vvCs.Get(action.id, action.idx));
+        vvCs.Erase(action.id, action.idx);
+        vvCs.Insert(action.id, action.idx, int_size(action.vIndices));
+        for(int i = 0; i < int_size(action.vIndices); i++) {
+          Assign(*vvCs.Get(action.id, action.idx + i), *vvCs.Get(action.fi, action.vIndices[i]));
         }
-        DelVec(vvCs[action.fi]);
+        DelSlab(vvCs, action.fi);
         Assign(vFs[action.fi], LitMax);
         Assign(vGs[action.fi], LitMax);
       }
@@ -267,13 +300,12 @@ namespace rrr {
         // time of this simulation is not measured for simplicity sake
         assert(vGs[action.fi] == LitMax);
         Assign(vGs[action.fi], vGs[action.id]);
-        std::vector<lit>::iterator it = vvCs[action.id].begin() + action.idx;
-        assert(vvCs[action.fi].empty());
-        vvCs[action.fi].insert(vvCs[action.fi].begin(), it, vvCs[action.id].end());
-        vvCs[action.id].erase(it, vvCs[action.id].end());
-        assert(vvCs[action.id].size() == action.idx);
-        vvCs[action.id].resize(action.idx + 1, LitMax);
-        Assign(vvCs[action.id][action.idx], vGs[action.fi]);
+        assert(vvCs.Size(action.fi) == 0);
+        vvCs.Resize(action.fi, vvCs.Size(action.id) - action.idx);
+        std::copy(vvCs.Get(action.id, action.idx), vvCs.Get(action.id, vvCs.Size(action.id)), vvCs.Get(action.fi, 0));
+        vvCs.Resize(action.id, action.idx); // references have been moved
+        vvCs.Resize(action.id, action.idx + 1);
+        Assign(*vvCs.Get(action.id, action.idx), vGs[action.fi]);
         vUpdates[action.fi] = false;
         vGUpdates[action.fi] = false;
         vCUpdates[action.fi] = vCUpdates[action.id];
@@ -281,10 +313,9 @@ namespace rrr {
       break;
     case SORT_FANINS:
       if(fInitialized) {
-        std::vector<lit> vCs = vvCs[action.id];
-        vvCs[action.id].clear();
-        for(int index: action.vIndices) {
-          vvCs[action.id].push_back(vCs[index]);
+        std::vector<lit> vCs(vvCs.Get(action.id, 0), vvCs.Get(action.id, vvCs.Size(action.id)));
+        for(int i = 0; i < int_size(action.vIndices); i++) {
+          *vvCs.Get(action.id, i) = vCs[action.vIndices[i]];
         }
         if(!fResim) {
           fResim = true;
@@ -345,7 +376,7 @@ namespace rrr {
     int nNodes = pNtk->GetNumNodes();
     vFs.resize(nNodes, LitMax);
     vGs.resize(nNodes, LitMax);
-    vvCs.resize(nNodes);
+    vvCs.Allocate(nNodes);
     vUpdates.resize(nNodes);
     vGUpdates.resize(nNodes);
     vCUpdates.resize(nNodes);
@@ -406,7 +437,7 @@ namespace rrr {
     lit x = pBdd->Const1();
     IncRef(x);
     pNtk->ForEachFanoutRidx(id, true, [&](int fo, int idx) {
-      Assign(x, pBdd->And(x, vvCs[fo][idx]));
+      Assign(x, pBdd->And(x, *vvCs.Get(fo, idx)));
     });
     if(pBdd->LitIsEq(vGs[id], x)) {
       DecRef(x);
@@ -420,11 +451,11 @@ namespace rrr {
   template <typename Ntk>
   inline void BddCspfAnalyzer<Ntk>::ComputeC(int id) {
     int nFanins = pNtk->GetNumFanins(id);
-    assert(vvCs[id].size() == nFanins);
+    assert(vvCs.Size(id) == nFanins);
     if(pBdd->IsConst1(vGs[id])) {
       for(int idx = 0; idx < nFanins; idx++) {
-        if(!pBdd->IsConst1(vvCs[id][idx])) {
-          Assign(vvCs[id][idx], pBdd->Const1());
+        if(!pBdd->IsConst1(*vvCs.Get(id, idx))) {
+          Assign(*vvCs.Get(id, idx), pBdd->Const1());
           int fi = pNtk->GetFanin(id, idx);
           vGUpdates[fi] = true;
         }
@@ -440,8 +471,8 @@ namespace rrr {
         Assign(x, pBdd->And(x, pBdd->LitNotCond(vFs[fi], c)));
       }
       Assign(x, pBdd->Or(pBdd->LitNot(x), vGs[id]));
-      if(!pBdd->LitIsEq(vvCs[id][idx], x)) {
-        Assign(vvCs[id][idx], x);
+      if(!pBdd->LitIsEq(*vvCs.Get(id, idx), x)) {
+        Assign(*vvCs.Get(id, idx), x);
         int fi = pNtk->GetFanin(id, idx);
         vGUpdates[fi] = true;
       }
@@ -506,19 +537,24 @@ namespace rrr {
     }
     DelVec(vFs);
     DelVec(vGs);
-    DelVecVec(vvCs);
+    DelSlab(vvCs);
     fInitialized = false;
     target = -1;
     fResim = false;
     vUpdates.clear();
     vGUpdates.clear();
     vCUpdates.clear();
-    if(!fReuse) {
+    if(!fReuse || (pBdd && pBdd->IsMemout())) {
       nNodesOld = 0;
       if(pBdd) {
         nNodesAccumulated += pBdd->GetNumTotalCreatedNodes();
+        if(pBdd->IsMemout()) {
+          delete pBdd;
+        } else {
+          delete pBddSpare;
+          pBddSpare = pBdd;
+        }
       }
-      delete pBdd;
       pBdd = NULL;
     }
   }
@@ -526,12 +562,39 @@ namespace rrr {
   template <typename Ntk>
   void BddCspfAnalyzer<Ntk>::Initialize() {
     bool fUseReo = false;
+    bool fPublish = false;
     if(!pBdd) {
-      NewBdd::Param Par;
-      pBdd = new NewBdd::Man(pNtk->GetNumPis(), Par);
-      fUseReo = true;
+      NewBdd::Man const *pBaseBdd = NULL;
+      if(pBase && int_size(vOrderKeys) == pNtk->GetNumPis()) {
+        pBaseBdd = pBase->Acquire(vOrderKeys, fPublish);
+      }
+      if(pBaseBdd) {
+        // base has nodes of same network in its reordered order
+        if(pBddSpare) {
+          pBdd = pBddSpare;
+          pBddSpare = NULL;
+          pBdd->Reset(*pBaseBdd);
+        } else {
+          pBdd = new NewBdd::Man(*pBaseBdd);
+        }
+      } else {
+        NewBdd::Param Par;
+        std::vector<NewBdd::var> vVar2Level;
+        if(pOrders && int_size(vOrderKeys) == pNtk->GetNumPis() && pOrders->Import(vOrderKeys, vVar2Level)) {
+          Par.pVar2Level = &vVar2Level;
+        }
+        if(pBddSpare) {
+          pBdd = pBddSpare;
+          pBddSpare = NULL;
+          pBdd->Reset(pNtk->GetNumPis(), Par);
+        } else {
+          pBdd = new NewBdd::Man(pNtk->GetNumPis(), Par);
+        }
+        fUseReo = true;
+      }
+      pBdd->SetStop(pStop);
     }
-    assert(pBdd->GetNumVars() == pNtk->GetNumPis());
+    assert((int)pBdd->GetNumVars() == pNtk->GetNumPis());
     Allocate();
     Assign(vFs[0], pBdd->Const0());
     int idx = 0;
@@ -548,13 +611,21 @@ namespace rrr {
       pBdd->Reorder();
       pBdd->TurnOffReo();
       durationReorder += Duration(timeStart, GetCurrentTime());
+      if(pOrders && int_size(vOrderKeys) == pNtk->GetNumPis() && !pBdd->IsMemout()) {
+        std::vector<int> vVar2Level;
+        pBdd->GetOrdering(vVar2Level);
+        pOrders->Export(vOrderKeys, vVar2Level);
+      }
+    }
+    if(fPublish) {
+      pBase->Publish(pBdd->IsMemout()? NULL: pBdd);
     }
     pNtk->ForEachInt([&](int id) {
-      vvCs[id].resize(pNtk->GetNumFanins(id), LitMax);
+      vvCs.Resize(id, pNtk->GetNumFanins(id));
     });
     pNtk->ForEachPo([&](int id) {
-      vvCs[id].resize(1, LitMax);
-      Assign(vvCs[id][0], pBdd->Const0());
+      vvCs.Resize(id, 1);
+      Assign(*vvCs.Get(id, 0), pBdd->Const0());
       int fi = pNtk->GetFanin(id, 0);
       vGUpdates[fi]  = true;
     });
@@ -573,10 +644,15 @@ namespace rrr {
     vBackups[slot].target = target;
     CopyVec(vBackups[slot].vFs, vFs);
     CopyVec(vBackups[slot].vGs, vGs);
-    CopyVecVec(vBackups[slot].vvCs, vvCs);
+    CopySlab(vBackups[slot].vvCs, vvCs);
     vBackups[slot].vUpdates = vUpdates;
     vBackups[slot].vGUpdates = vGUpdates;
     vBackups[slot].vCUpdates = vCUpdates;
+    if(pBdd) {
+      vBackups[slot].snapshot = pBdd->TakeSnapshot();
+    } else {
+      vBackups[slot].snapshot = {0, 0};
+    }
   }
 
   template <typename Ntk>
@@ -585,10 +661,11 @@ namespace rrr {
     target = vBackups[slot].target;
     CopyVec(vFs, vBackups[slot].vFs);
     CopyVec(vGs, vBackups[slot].vGs);
-    CopyVecVec(vvCs, vBackups[slot].vvCs);
+    CopySlab(vvCs, vBackups[slot].vvCs);
     vUpdates = vBackups[slot].vUpdates;
     vGUpdates = vBackups[slot].vGUpdates;
     vCUpdates = vBackups[slot].vCUpdates;
+    Restore(slot);
   }
 
   template <typename Ntk>
@@ -596,10 +673,27 @@ namespace rrr {
     assert(!vBackups.empty());
     DelVec(vBackups.back().vFs);
     DelVec(vBackups.back().vGs);
-    DelVecVec(vBackups.back().vvCs);
+    DelSlab(vBackups.back().vvCs);
     vBackups.pop_back();
   }
 
+  template <typename Ntk>
+  void BddCspfAnalyzer<Ntk>::Restore(int slot) {
+    // dead nodes are kept as they may be looked up again, until manager runs short of nodes
+    if(!pBdd || !pBdd->IsCrowded()) {
+      return;
+    }
+    // nodes created since save are no longer referenced unless a backup was saved after it
+    for(int i = 0; i < int_size(vBackups); i++) {
+      if(vBackups[i].snapshot.nObjs > vBackups[slot].snapshot.nObjs) {
+        return;
+      }
+    }
+    if(pBdd->Restore(vBackups[slot].snapshot)) {
+      nRestores++;
+    }
+  }
+
   /* }}} */
   
   /* {{{ Constructors */
@@ -611,8 +705,14 @@ namespace rrr {
     fSave(false),
     fInitialized(false),
     pBdd(NULL),
+    pBddSpare(NULL),
+    pStop(NULL),
+    pOrders(NULL),
+    pBase(NULL),
     target(-1),
-    fResim(false) {
+    vvCs(1, LitMax),
+    fResim(false),
+    snapshot({0, 0}) {
     ResetSummary();
   }
   
@@ -623,14 +723,21 @@ namespace rrr {
     fSave(pPar->fSave),
     fInitialized(false),
     pBdd(NULL),
+    pBddSpare(NULL),
+    pStop(NULL),
+    pOrders(NULL),
+    pBase(NULL),
     target(-1),
-    fResim(false) {
+    vvCs(1, LitMax),
+    fResim(false),
+    snapshot({0, 0}) {
     ResetSummary();
   }
   
   template <typename Ntk>
   BddCspfAnalyzer<Ntk>::~BddCspfAnalyzer() {
     Reset();
+    delete pBddSpare;
   }
 
   template <typename Ntk>
@@ -640,6 +747,34 @@ namespace rrr {
     pNtk->AddCallback(std::bind(&BddCspfAnalyzer<Ntk>::ActionCallback, this, std::placeholders::_1));
   }
 
+  template <typename Ntk>
+  void BddCspfAnalyzer<Ntk>::SetTimeBudget(time_point, seconds) {
+  }
+
+  template <typename Ntk>
+  void BddCspfAnalyzer<Ntk>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    if(pBdd) {
+      pBdd->SetStop(pStop);
+    }
+  }
+
+  template <typename Ntk>
+  bool BddCspfAnalyzer<Ntk>::IsMemout() const {
+    return pBdd && pBdd->IsMemout();
+  }
+
+  template <typename Ntk>
+  void BddCspfAnalyzer<Ntk>::SetOrderTable(OrderTable *pOrders_, std::vector<int> const &vKeys) {
+    pOrders = pOrders_;
+    vOrderKeys = vKeys;
+  }
+
+  template <typename Ntk>
+  void BddCspfAnalyzer<Ntk>::SetBddBase(BddBase *pBase_) {
+    pBase = pBase_;
+  }
+
   /* }}} */
 
   /* {{{ Checks */
@@ -659,7 +794,7 @@ namespace rrr {
     case AND: {
       int fi = pNtk->GetFanin(id, idx);
       bool c = pNtk->GetCompl(id, idx);
-      lit x = pBdd->Or(pBdd->LitNotCond(vFs[fi], c), vvCs[id][idx]);
+      lit x = pBdd->Or(pBdd->LitNotCond(vFs[fi], c), *vvCs.Get(id, idx));
       if(pBdd->IsConst1(x)) {
         fRedundant = true;
       }
@@ -720,6 +855,24 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Multiple removal */
+
+  template <typename Ntk>
+  bool BddCspfAnalyzer<Ntk>::GetRedundantFanins(int, std::vector<int> &) {
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk>
+  bool BddCspfAnalyzer<Ntk>::GetCandidates(int, std::vector<int> &, bool) {
+    return false;
+  }
+
+  /* }}} */
+
   /* {{{ Summary */
 
   template <typename Ntk>
@@ -730,6 +883,7 @@ namespace rrr {
       nNodesOld = 0;
     }
     nNodesAccumulated = 0;
+    nRestores = 0;
     durationSimulation = 0;
     durationPf = 0;
     durationCheck = 0;
@@ -740,6 +894,7 @@ namespace rrr {
   summary<int> BddCspfAnalyzer<Ntk>::GetStatsSummary() const {
     summary<int> v;
     v.emplace_back("bdd node", pBdd->GetNumTotalCreatedNodes() - nNodesOld + nNodesAccumulated);
+    v.emplace_back("bdd restore", nRestores);
     return v;
   }
   
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "misc/rrrParameter.h"
+#include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
+
+namespace rrr {
+
+  // BDD analyzer that hands current network over to another analyzer once BDD nodes run out
+  template <typename Ntk, typename BddAna, typename Ana>
+  class BddFallbackAnalyzer {
+  private:
+    // pointer to network
+    Ntk *pNtk;
+
+    // parameters
+    int nVerbose;
+    Parameter ParFallback;
+
+    // data
+    BddAna bdd;
+    Ana ana;
+    bool fFallback;
+
+    // stats
+    int nFallbacks;
+
+    // fallback
+    static Parameter GetFallbackParameter(Parameter const *pPar);
+    bool IsFallback();
+
+  public:
+    // constructors
+    BddFallbackAnalyzer(Parameter const *pPar);
+    void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop); // queries are given up once *pStop becomes nonzero
+    void SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys);
+    void SetBddBase(BddBase *pBase);
+
+    // checks
+    bool CheckRedundancy(int id, int idx);
+    bool CheckFeasibility(int id, int fi, bool c);
+
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
+    // summary
+    void ResetSummary();
+    summary<int> GetStatsSummary() const;
+    summary<double> GetTimesSummary() const;
+  };
+
+  /* {{{ Fallback */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  Parameter BddFallbackAnalyzer<Ntk, BddAna, Ana>::GetFallbackParameter(Parameter const *pPar) {
+    // backups taken before switching are unknown to fallback, so it is reinitialized on load instead
+    Parameter Par = *pPar;
+    Par.fSave = false;
+    return Par;
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  bool BddFallbackAnalyzer<Ntk, BddAna, Ana>::IsFallback() {
+    if(fFallback) {
+      return true;
+    }
+    if(!bdd.IsMemout()) {
+      return false;
+    }
+    if(nVerbose) {
+      std::cout << "bdd memout, switching to fallback analyzer" << std::endl;
+    }
+    fFallback = true;
+    nFallbacks++;
+    ana.AssignNetwork(pNtk, false);
+    return true;
+  }
+
+  /* }}} */
+
+  /* {{{ Constructors */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  BddFallbackAnalyzer<Ntk, BddAna, Ana>::BddFallbackAnalyzer(Parameter const *pPar) :
+    pNtk(NULL),
+    nVerbose(pPar->nAnalyzerVerbose),
+    ParFallback(GetFallbackParameter(pPar)),
+    bdd(pPar),
+    ana(&ParFallback),
+    fFallback(false) {
+    ResetSummary();
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::AssignNetwork(Ntk *pNtk_, bool fReuse) {
+    pNtk = pNtk_;
+    fFallback = false;
+    bdd.AssignNetwork(pNtk, fReuse);
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::SetTimeBudget(time_point start, seconds nTimeout) {
+    bdd.SetTimeBudget(start, nTimeout);
+    ana.SetTimeBudget(start, nTimeout);
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::SetStop(int *pStop) {
+    bdd.SetStop(pStop);
+    ana.SetStop(pStop);
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys) {
+    bdd.SetOrderTable(pOrders, vKeys);
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::SetBddBase(BddBase *pBase) {
+    bdd.SetBddBase(pBase);
+  }
+
+  /* }}} */
+
+  /* {{{ Checks */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  bool BddFallbackAnalyzer<Ntk, BddAna, Ana>::CheckRedundancy(int id, int idx) {
+    if(!IsFallback()) {
+      bool fRedundant = bdd.CheckRedundancy(id, idx);
+      if(!IsFallback()) {
+        return fRedundant;
+      }
+    }
+    return ana.CheckRedundancy(id, idx);
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  bool BddFallbackAnalyzer<Ntk, BddAna, Ana>::CheckFeasibility(int id, int fi, bool c) {
+    if(!IsFallback()) {
+      bool fFeasible = bdd.CheckFeasibility(id, fi, c);
+      if(!IsFallback()) {
+        return fFeasible;
+      }
+    }
+    return ana.CheckFeasibility(id, fi, c);
+  }
+
+  /* }}} */
+
+  /* {{{ Multiple removal */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  bool BddFallbackAnalyzer<Ntk, BddAna, Ana>::GetRedundantFanins(int id, std::vector<int> &vIdxs) {
+    if(!IsFallback()) {
+      bool fSupported = bdd.GetRedundantFanins(id, vIdxs);
+      if(!IsFallback()) {
+        return fSupported;
+      }
+    }
+    return ana.GetRedundantFanins(id, vIdxs);
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  bool BddFallbackAnalyzer<Ntk, BddAna, Ana>::GetCandidates(int id, std::vector<int> &vCands, bool fCompl) {
+    if(!IsFallback()) {
+      bool fSupported = bdd.GetCandidates(id, vCands, fCompl);
+      if(!IsFallback()) {
+        return fSupported;
+      }
+    }
+    return ana.GetCandidates(id, vCands, fCompl);
+  }
+
+  /* }}} */
+
+  /* {{{ Summary */
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  void BddFallbackAnalyzer<Ntk, BddAna, Ana>::ResetSummary() {
+    bdd.ResetSummary();
+    ana.ResetSummary();
+    nFallbacks = 0;
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  summary<int> BddFallbackAnalyzer<Ntk, BddAna, Ana>::GetStatsSummary() const {
+    summary<int> v = bdd.GetStatsSummary();
+    v.emplace_back("bdd fallback", nFallbacks);
+    if(fFallback || nFallbacks) {
+      summary<int> v2 = ana.GetStatsSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    return v;
+  }
+
+  template <typename Ntk, typename BddAna, typename Ana>
+  summary<double> BddFallbackAnalyzer<Ntk, BddAna, Ana>::GetTimesSummary() const {
+    summary<double> v = bdd.GetTimesSummary();
+    if(fFallback || nFallbacks) {
+      summary<double> v2 = ana.GetTimesSummary();
+      v.insert(v.end(), v2.begin(), v2.end());
+    }
+    return v;
+  }
+
+  /* }}} */
+
+}
@@ -2,6 +2,8 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
 #include "engine/rrrBddManager.h"
 
 namespace rrr {
@@ -24,11 +26,17 @@ namespace rrr {
     bool fInitialized;
     int target;
     NewBdd::Man *pBdd;
+    NewBdd::Man *pBddSpare; // manager of previous network, whose storage is reused
+    int *pStop;
+    OrderTable *pOrders;
+    BddBase *pBase;
+    std::vector<int> vOrderKeys; // identities of inputs in order table
     lit care;
     std::vector<lit> vFs;
 
     // backups
     std::vector<BddResimAnalyzer> vBackups;
+    NewBdd::Man::Snapshot snapshot; // manager size when saved as backup
     
     // updates
     bool fUpdate;
@@ -38,6 +46,7 @@ namespace rrr {
     // stats
     uint64_t nNodesOld;
     uint64_t nNodesAccumulated;
+    int nRestores;
     double durationSimulation;
     double durationPf;
     double durationCheck;
@@ -71,6 +80,7 @@ namespace rrr {
     void Save(int slot);
     void Load(int slot);
     void PopBack();
+    void Restore(int slot);
     
   public:
     // constructors
@@ -78,10 +88,21 @@ namespace rrr {
     BddResimAnalyzer(Parameter const *pPar);
     ~BddResimAnalyzer();
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop); // queries are given up once *pStop becomes nonzero
+    bool IsMemout() const; // nodes ran out, after which queries are given up
+    void SetOrderTable(OrderTable *pOrders_, std::vector<int> const &vKeys); // new managers start from order in table and export theirs
+    void SetBddBase(BddBase *pBase_); // new managers are copied from base, which first one builds
 
     // checks
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
+
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
     
     // summary
     void ResetSummary();
@@ -172,6 +193,10 @@ namespace rrr {
 
   template <typename Ntk>
   void BddResimAnalyzer<Ntk>::ActionCallback(Action const &action) {
+    if(IsMemout()) {
+      // network is left to another analyzer until reassigned
+      return;
+    }
     switch(action.type) {
     case REMOVE_FANIN:
       assert(fInitialized);
@@ -352,12 +377,17 @@ namespace rrr {
     fUpdate = false;
     sUpdates.clear();
     vUpdates.clear();
-    if(!fReuse) {
+    if(!fReuse || (pBdd && pBdd->IsMemout())) {
       nNodesOld = 0;
       if(pBdd) {
         nNodesAccumulated += pBdd->GetNumTotalCreatedNodes();
+        if(pBdd->IsMemout()) {
+          delete pBdd;
+        } else {
+          delete pBddSpare;
+          pBddSpare = pBdd;
+        }
       }
-      delete pBdd;
       pBdd = NULL;
     }
   }
@@ -365,12 +395,39 @@ namespace rrr {
   template <typename Ntk>
   void BddResimAnalyzer<Ntk>::Initialize() {
     bool fUseReo = false;
+    bool fPublish = false;
     if(!pBdd) {
-      NewBdd::Param Par;
-      pBdd = new NewBdd::Man(pNtk->GetNumPis(), Par);
-      fUseReo = true;
+      NewBdd::Man const *pBaseBdd = NULL;
+      if(pBase && int_size(vOrderKeys) == pNtk->GetNumPis()) {
+        pBaseBdd = pBase->Acquire(vOrderKeys, fPublish);
+      }
+      if(pBaseBdd) {
+        // base has nodes of same network in its reordered order
+        if(pBddSpare) {
+          pBdd = pBddSpare;
+          pBddSpare = NULL;
+          pBdd->Reset(*pBaseBdd);
+        } else {
+          pBdd = new NewBdd::Man(*pBaseBdd);
+        }
+      } else {
+        NewBdd::Param Par;
+        std::vector<NewBdd::var> vVar2Level;
+        if(pOrders && int_size(vOrderKeys) == pNtk->GetNumPis() && pOrders->Import(vOrderKeys, vVar2Level)) {
+          Par.pVar2Level = &vVar2Level;
+        }
+        if(pBddSpare) {
+          pBdd = pBddSpare;
+          pBddSpare = NULL;
+          pBdd->Reset(pNtk->GetNumPis(), Par);
+        } else {
+          pBdd = new NewBdd::Man(pNtk->GetNumPis(), Par);
+        }
+        fUseReo = true;
+      }
+      pBdd->SetStop(pStop);
     }
-    assert(pBdd->GetNumVars() == pNtk->GetNumPis());
+    assert((int)pBdd->GetNumVars() == pNtk->GetNumPis());
     vFs.resize(pNtk->GetNumNodes(), LitMax);
     Assign(vFs[0], pBdd->Const0());
     int idx = 0;
@@ -388,6 +445,14 @@ namespace rrr {
       pBdd->Reorder();
       pBdd->TurnOffReo();
       durationReorder += Duration(timeStart, GetCurrentTime());
+      if(pOrders && int_size(vOrderKeys) == pNtk->GetNumPis() && !pBdd->IsMemout()) {
+        std::vector<int> vVar2Level;
+        pBdd->GetOrdering(vVar2Level);
+        pOrders->Export(vOrderKeys, vVar2Level);
+      }
+    }
+    if(fPublish) {
+      pBase->Publish(pBdd->IsMemout()? NULL: pBdd);
     }
     fInitialized = true;
   }
@@ -403,6 +468,7 @@ namespace rrr {
     }
     vBackups[slot].fInitialized = fInitialized;
     if(!fInitialized) {
+      vBackups[slot].snapshot = {0, 0};
       return;
     }
     if(sUpdates.empty()) {
@@ -425,6 +491,7 @@ namespace rrr {
     }
     target = vBackups[slot].target; // assigned to -1 when careset needs updating
     CopyVec(vBackups[slot].vFs, vFs);
+    vBackups[slot].snapshot = pBdd->TakeSnapshot();
   }
 
   template <typename Ntk>
@@ -441,6 +508,7 @@ namespace rrr {
     sUpdates.clear();
     vUpdates.clear();
     vUpdates.resize(pNtk->GetNumNodes());
+    Restore(slot);
   }
 
   template <typename Ntk>
@@ -451,6 +519,23 @@ namespace rrr {
     vBackups.pop_back();
   }
 
+  template <typename Ntk>
+  void BddResimAnalyzer<Ntk>::Restore(int slot) {
+    // dead nodes are kept as they may be looked up again, until manager runs short of nodes
+    if(!pBdd || !pBdd->IsCrowded()) {
+      return;
+    }
+    // nodes created since save are no longer referenced unless a backup was saved after it
+    for(int i = 0; i < int_size(vBackups); i++) {
+      if(vBackups[i].snapshot.nObjs > vBackups[slot].snapshot.nObjs) {
+        return;
+      }
+    }
+    if(pBdd->Restore(vBackups[slot].snapshot)) {
+      nRestores++;
+    }
+  }
+
   /* }}} */
   
   /* {{{ Constructor */
@@ -463,7 +548,12 @@ namespace rrr {
     fInitialized(false),
     target(-1),
     pBdd(NULL),
+    pBddSpare(NULL),
+    pStop(NULL),
+    pOrders(NULL),
+    pBase(NULL),
     care(LitMax),
+    snapshot({0, 0}),
     fUpdate(false) {
     ResetSummary();
   }
@@ -476,7 +566,12 @@ namespace rrr {
     fInitialized(false),
     target(-1),
     pBdd(NULL),
+    pBddSpare(NULL),
+    pStop(NULL),
+    pOrders(NULL),
+    pBase(NULL),
     care(LitMax),
+    snapshot({0, 0}),
     fUpdate(false) {
     ResetSummary();
   }
@@ -484,6 +579,7 @@ namespace rrr {
   template <typename Ntk>
   BddResimAnalyzer<Ntk>::~BddResimAnalyzer() {
     Reset();
+    delete pBddSpare;
   }
 
   template <typename Ntk>
@@ -492,6 +588,34 @@ namespace rrr {
     pNtk = pNtk_;
     pNtk->AddCallback(std::bind(&BddResimAnalyzer<Ntk>::ActionCallback, this, std::placeholders::_1));
   }
+
+  template <typename Ntk>
+  void BddResimAnalyzer<Ntk>::SetTimeBudget(time_point, seconds) {
+  }
+
+  template <typename Ntk>
+  void BddResimAnalyzer<Ntk>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    if(pBdd) {
+      pBdd->SetStop(pStop);
+    }
+  }
+
+  template <typename Ntk>
+  bool BddResimAnalyzer<Ntk>::IsMemout() const {
+    return pBdd && pBdd->IsMemout();
+  }
+
+  template <typename Ntk>
+  void BddResimAnalyzer<Ntk>::SetOrderTable(OrderTable *pOrders_, std::vector<int> const &vKeys) {
+    pOrders = pOrders_;
+    vOrderKeys = vKeys;
+  }
+
+  template <typename Ntk>
+  void BddResimAnalyzer<Ntk>::SetBddBase(BddBase *pBase_) {
+    pBase = pBase_;
+  }
   
   /* }}} */
 
@@ -572,6 +696,24 @@ namespace rrr {
 
   /* }}} */
   
+  /* {{{ Multiple removal */
+
+  template <typename Ntk>
+  bool BddResimAnalyzer<Ntk>::GetRedundantFanins(int, std::vector<int> &) {
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk>
+  bool BddResimAnalyzer<Ntk>::GetCandidates(int, std::vector<int> &, bool) {
+    return false;
+  }
+
+  /* }}} */
+
   /* {{{ Summary */
 
   template <typename Ntk>
@@ -582,6 +724,7 @@ namespace rrr {
       nNodesOld = 0;
     }
     nNodesAccumulated = 0;
+    nRestores = 0;
     durationSimulation = 0;
     durationPf = 0;
     durationCheck = 0;
@@ -592,6 +735,7 @@ namespace rrr {
   summary<int> BddResimAnalyzer<Ntk>::GetStatsSummary() const {
     summary<int> v;
     v.emplace_back("bdd node", pBdd->GetNumTotalCreatedNodes() - nNodesOld + nNodesAccumulated);
+    v.emplace_back("bdd restore", nRestores);
     return v;
   }
   
@@ -2,6 +2,8 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
 
 namespace rrr {
 
@@ -22,11 +24,21 @@ namespace rrr {
     // constructors
     TtAnalyzer(Parameter const *pPar);
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop); // queries are given up once *pStop becomes nonzero
+    void SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys); // unused as no BDDs are built
+    void SetBddBase(BddBase *pBase); // unused as no BDDs are built
 
     // checks
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
 
+    // multiple removal (returns false if unsupported)
+    bool GetRedundantFanins(int id, std::vector<int> &vIdxs);
+
+    // candidates (returns false if unsupported)
+    bool GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
     // summary
     void ResetSummary();
     summary<int> GetStatsSummary() const;
@@ -48,6 +60,22 @@ namespace rrr {
     sim.AssignNetwork(pNtk, fReuse);
   }
 
+  template <typename Ntk, typename Sim>
+  void TtAnalyzer<Ntk, Sim>::SetTimeBudget(time_point, seconds) {
+  }
+
+  template <typename Ntk, typename Sim>
+  void TtAnalyzer<Ntk, Sim>::SetStop(int *) {
+  }
+
+  template <typename Ntk, typename Sim>
+  void TtAnalyzer<Ntk, Sim>::SetOrderTable(OrderTable *, std::vector<int> const &) {
+  }
+
+  template <typename Ntk, typename Sim>
+  void TtAnalyzer<Ntk, Sim>::SetBddBase(BddBase *) {
+  }
+
   /* }}} */
 
   /* {{{ Checks */
@@ -64,6 +92,24 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Multiple removal */
+
+  template <typename Ntk, typename Sim>
+  bool TtAnalyzer<Ntk, Sim>::GetRedundantFanins(int, std::vector<int> &) {
+    return false;
+  }
+
+  /* }}} */
+
+  /* {{{ Candidates */
+
+  template <typename Ntk, typename Sim>
+  bool TtAnalyzer<Ntk, Sim>::GetCandidates(int, std::vector<int> &, bool) {
+    return false;
+  }
+
+  /* }}} */
+
   /* {{{ Summary */
   
   template <typename Ntk, typename Sim>
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+#include "misc/rrrParameter.h"
+#include "misc/rrrUtils.h"
+
+namespace rrr {
+
+  // conflict limits of SAT queries derived from conflicts needed by resolved queries and remaining time
+  class ConflictBudget {
+  private:
+    // parameters
+    int nConflictLimit; // static limit used until enough samples are collected (0 = no limit)
+    int nPercentile; // percentile of resolved queries (0 = static limit)
+    int nRetries; // number of retries of undetermined queries
+    static constexpr int nMinSamples = 32;
+    static constexpr int nMinLimit = 100;
+    static constexpr int nMargin = 2; // limit is this many times percentile
+    static constexpr int nEscalation = 4; // limit grows by this factor on each retry
+    static constexpr int nSlackRatio = 16; // query may take up to this fraction of remaining time
+
+    // data
+    time_point start;
+    seconds nTimeout;
+    std::vector<int> vSamples; // conflicts of resolved queries in current network
+    std::vector<int> vTmp;
+    int nLimit; // limit derived from samples
+    int nSamplesUpdated; // number of samples when limit was derived
+    double nConflictsTotal; // for conflicts per second
+    double durationTotal;
+
+    // stats
+    int nQueries;
+    int nUndets;
+    int nRetried;
+    int nRetriesResolved;
+    int64_t nConflictsUsed;
+    int64_t nConflictsAllowed;
+
+    // limit
+    void UpdateLimit();
+    double GetRemainingTime() const;
+
+  public:
+    // constructors
+    ConflictBudget(Parameter const *pPar);
+    void Reset();
+    void SetTimeBudget(time_point start_, seconds nTimeout_);
+
+    // queries
+    int  GetLimit(int iRetry);
+    void Record(SatResult res, int nConflicts, int nLimit_, double duration, int iRetry);
+    bool Retry(int iRetry) const;
+
+    // stats
+    void ResetSummary();
+    summary<int> GetStatsSummary() const;
+  };
+
+  /* {{{ Limit */
+
+  inline void ConflictBudget::UpdateLimit() {
+    // recompute when samples have grown by half
+    if(int_size(vSamples) < nMinSamples || 2 * int_size(vSamples) < 3 * nSamplesUpdated) {
+      return;
+    }
+    vTmp = vSamples;
+    int k = (int)((int64_t)(int_size(vTmp) - 1) * nPercentile / 100);
+    std::nth_element(vTmp.begin(), vTmp.begin() + k, vTmp.end());
+    nLimit = std::max(nMinLimit, nMargin * vTmp[k]);
+    nSamplesUpdated = int_size(vSamples);
+  }
+
+  inline double ConflictBudget::GetRemainingTime() const {
+    return nTimeout - Duration(start, GetCurrentTime());
+  }
+
+  /* }}} */
+
+  /* {{{ Constructors */
+
+  inline ConflictBudget::ConflictBudget(Parameter const *pPar) :
+    nConflictLimit(pPar->nConflictLimit),
+    nPercentile(pPar->nConflictPercentile),
+    nRetries(pPar->nConflictRetries),
+    nTimeout(0) {
+    assert(nPercentile >= 0 && nPercentile <= 100);
+    Reset();
+    ResetSummary();
+  }
+
+  inline void ConflictBudget::Reset() {
+    vSamples.clear();
+    nLimit = nConflictLimit;
+    nSamplesUpdated = 0;
+    nConflictsTotal = 0;
+    durationTotal = 0;
+  }
+
+  inline void ConflictBudget::SetTimeBudget(time_point start_, seconds nTimeout_) {
+    start = start_;
+    nTimeout = nTimeout_;
+  }
+
+  /* }}} */
+
+  /* {{{ Queries */
+
+  inline int ConflictBudget::GetLimit(int iRetry) {
+    if(!nPercentile && !nRetries) {
+      return nConflictLimit;
+    }
+    if(nPercentile) {
+      UpdateLimit();
+    }
+    int64_t n = nLimit;
+    if(!n) {
+      return 0;
+    }
+    for(int i = 0; i < iRetry; i++) {
+      n *= nEscalation;
+    }
+    // leave most of remaining time to other queries
+    if(nTimeout && nConflictsTotal > 0 && durationTotal > 0) {
+      double nRate = nConflictsTotal / durationTotal;
+      double nCap = std::max(0.0, GetRemainingTime()) * nRate / nSlackRatio;
+      if(nCap < n) {
+        n = std::max((int64_t)nMinLimit, (int64_t)nCap);
+      }
+    }
+    return (int)std::min(n, (int64_t)std::numeric_limits<int>::max());
+  }
+
+  inline void ConflictBudget::Record(SatResult res, int nConflicts, int nLimit_, double duration, int iRetry) {
+    nConflictsTotal += nConflicts;
+    durationTotal += duration;
+    nQueries++;
+    nConflictsUsed += nConflicts;
+    nConflictsAllowed += nLimit_;
+    if(iRetry) {
+      nRetried++;
+    }
+    if(res == UNDET) {
+      nUndets++;
+      return;
+    }
+    if(iRetry) {
+      nRetriesResolved++;
+    }
+    vSamples.push_back(nConflicts);
+  }
+
+  inline bool ConflictBudget::Retry(int iRetry) const {
+    if(iRetry >= nRetries) {
+      return false;
+    }
+    if(nTimeout && GetRemainingTime() <= 0) {
+      return false;
+    }
+    return true;
+  }
+
+  /* }}} */
+
+  /* {{{ Stats */
+
+  inline void ConflictBudget::ResetSummary() {
+    nQueries = 0;
+    nUndets = 0;
+    nRetried = 0;
+    nRetriesResolved = 0;
+    nConflictsUsed = 0;
+    nConflictsAllowed = 0;
+  }
+
+  inline summary<int> ConflictBudget::GetStatsSummary() const {
+    summary<int> v;
+    if(!nPercentile && !nRetries) {
+      return v;
+    }
+    v.emplace_back("sat budget query", nQueries);
+    v.emplace_back("sat budget undetermined", nUndets);
+    v.emplace_back("sat budget retry", nRetried);
+    v.emplace_back("sat budget retry resolved", nRetriesResolved);
+    v.emplace_back("sat budget conflict used", (int)std::min(nConflictsUsed, (int64_t)std::numeric_limits<int>::max()));
+    v.emplace_back("sat budget conflict allowed", (int)std::min(nConflictsAllowed, (int64_t)std::numeric_limits<int>::max()));
+    v.emplace_back("sat budget limit", nLimit);
+    return v;
+  }
+
+  /* }}} */
+
+}
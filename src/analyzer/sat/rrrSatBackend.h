@@ -0,0 +1,600 @@
+#pragma once
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+
+#include <sat/bsat/satSolver.h>
+#include <sat/glucose/AbcGlucose.h>
+// satoko headers do not compile cleanly with -Wall -Wextra
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wtype-limits"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <sat/satoko/satoko.h>
+#pragma GCC diagnostic pop
+
+#include "misc/rrrParameter.h"
+#include "misc/rrrTypes.h"
+#include "misc/rrrUtils.h"
+
+ABC_NAMESPACE_USING_NAMESPACE
+
+namespace rrr {
+
+  // incremental SAT solver with literals in ABC convention (2 * var + sign)
+  class SatBackend {
+  public:
+    virtual ~SatBackend() = default;
+
+    virtual void Restart() = 0;
+    virtual int  AddVar() = 0;
+    virtual int  GetNumVars() = 0;
+    virtual bool AddClause(int const *pLits, int nLits) = 0; // false if trivially UNSAT
+    virtual SatResult Solve(int const *pLits, int nLits, int nConflictLimit) = 0; // 0 = no limit
+    virtual bool GetValue(int iVar) = 0; // after SAT
+    virtual int  GetNumConflicts() = 0; // accumulated over calls
+    virtual void GetCore(std::vector<int> &vCore) = 0; // assumptions responsible for UNSAT
+    virtual void SetStop(int *pStop) = 0; // solving returns UNDET once *pStop becomes nonzero
+
+    // stats
+    virtual void ResetSummary() {}
+    virtual summary<int> GetStatsSummary() const {
+      return summary<int>();
+    }
+
+    /* {{{ Gates */
+
+    void AddConst(int iVar, bool fCompl) {
+      int iLit = toLitCond(iVar, fCompl);
+      bool r = AddClause(&iLit, 1);
+      assert(r);
+      (void)r;
+    }
+
+    void AddBuffer(int iVarA, int iVarB, bool fCompl) {
+      int Lits[2];
+      bool r;
+      Lits[0] = toLitCond(iVarA, 0);
+      Lits[1] = toLitCond(iVarB, !fCompl);
+      r = AddClause(Lits, 2);
+      assert(r);
+      Lits[0] = toLitCond(iVarA, 1);
+      Lits[1] = toLitCond(iVarB, fCompl);
+      r = AddClause(Lits, 2);
+      assert(r);
+      (void)r;
+    }
+
+    void AddAnd(int iVar, int iVar0, int iVar1, bool fCompl0, bool fCompl1) {
+      int Lits[3];
+      bool r;
+      Lits[0] = toLitCond(iVar, 1);
+      Lits[1] = toLitCond(iVar0, fCompl0);
+      r = AddClause(Lits, 2);
+      assert(r);
+      Lits[0] = toLitCond(iVar, 1);
+      Lits[1] = toLitCond(iVar1, fCompl1);
+      r = AddClause(Lits, 2);
+      assert(r);
+      Lits[0] = toLitCond(iVar, 0);
+      Lits[1] = toLitCond(iVar0, !fCompl0);
+      Lits[2] = toLitCond(iVar1, !fCompl1);
+      r = AddClause(Lits, 3);
+      assert(r);
+      (void)r;
+    }
+
+    // n-ary and over fanin literals with one binary clause per fanin and one long clause
+    void AddAnd(int iVar, std::vector<int> const &vFaninLits) {
+      std::vector<int> vLits(1, toLitCond(iVar, 1));
+      bool r;
+      for(int iLit: vFaninLits) {
+        vLits.resize(2);
+        vLits[1] = iLit;
+        r = AddClause(vLits.data(), 2);
+        assert(r);
+      }
+      vLits.resize(1);
+      vLits[0] = toLitCond(iVar, 0);
+      for(int iLit: vFaninLits) {
+        vLits.push_back(lit_neg(iLit));
+      }
+      r = AddClause(vLits.data(), int_size(vLits));
+      assert(r);
+      (void)r;
+    }
+
+    void AddXor(int iVarA, int iVarB, int iVarC) {
+      int Lits[3];
+      bool r;
+      Lits[0] = toLitCond(iVarA, 1);
+      Lits[1] = toLitCond(iVarB, 1);
+      Lits[2] = toLitCond(iVarC, 1);
+      r = AddClause(Lits, 3);
+      assert(r);
+      Lits[0] = toLitCond(iVarA, 1);
+      Lits[1] = toLitCond(iVarB, 0);
+      Lits[2] = toLitCond(iVarC, 0);
+      r = AddClause(Lits, 3);
+      assert(r);
+      Lits[0] = toLitCond(iVarA, 0);
+      Lits[1] = toLitCond(iVarB, 1);
+      Lits[2] = toLitCond(iVarC, 0);
+      r = AddClause(Lits, 3);
+      assert(r);
+      Lits[0] = toLitCond(iVarA, 0);
+      Lits[1] = toLitCond(iVarB, 0);
+      Lits[2] = toLitCond(iVarC, 1);
+      r = AddClause(Lits, 3);
+      assert(r);
+      (void)r;
+    }
+
+    /* }}} */
+  };
+
+  /* {{{ Bsat */
+
+  // bsat stops through a callback without context, so flag is given per thread
+  inline int *&BsatStopFlag() {
+    static thread_local int *pStop = NULL;
+    return pStop;
+  }
+
+  inline int BsatStopFunc(int RunId) {
+    (void)RunId;
+    int *pStop = BsatStopFlag();
+    return pStop && *pStop;
+  }
+
+  class BsatBackend : public SatBackend {
+  private:
+    sat_solver *pSat;
+    int *pStop;
+    std::vector<int> vLits;
+
+  public:
+    BsatBackend() :
+      pSat(sat_solver_new()),
+      pStop(NULL) {
+    }
+
+    ~BsatBackend() {
+      sat_solver_delete(pSat);
+    }
+
+    void Restart() override {
+      sat_solver_restart(pSat);
+    }
+
+    int AddVar() override {
+      return sat_solver_addvar(pSat);
+    }
+
+    int GetNumVars() override {
+      return sat_solver_nvars(pSat);
+    }
+
+    bool AddClause(int const *pLits, int nLits) override {
+      vLits.assign(pLits, pLits + nLits);
+      return sat_solver_addclause(pSat, vLits.data(), vLits.data() + nLits);
+    }
+
+    SatResult Solve(int const *pLits, int nLits, int nConflictLimit) override {
+      vLits.assign(pLits, pLits + nLits);
+      BsatStopFlag() = pStop;
+      int res = sat_solver_solve(pSat, vLits.data(), vLits.data() + nLits, nConflictLimit, 0 /*nInsLimit*/, 0 /*nConfLimitGlobal*/, 0 /*nInsLimitGlobal*/);
+      if(res == l_True) {
+        return SAT;
+      }
+      if(res == l_False) {
+        return UNSAT;
+      }
+      return UNDET;
+    }
+
+    bool GetValue(int iVar) override {
+      return sat_solver_var_value(pSat, iVar);
+    }
+
+    int GetNumConflicts() override {
+      return sat_solver_nconflicts(pSat);
+    }
+
+    void GetCore(std::vector<int> &vCore) override {
+      int *pLits;
+      int nLits = sat_solver_final(pSat, &pLits);
+      vCore.clear();
+      for(int i = 0; i < nLits; i++) {
+        vCore.push_back(lit_neg(pLits[i]));
+      }
+    }
+
+    void SetStop(int *pStop_) override {
+      pStop = pStop_;
+      sat_solver_set_stop_func(pSat, pStop? BsatStopFunc: NULL);
+    }
+  };
+
+  /* }}} */
+
+  /* {{{ Glucose */
+
+  class GlucoseBackend : public SatBackend {
+  private:
+    bmcg_sat_solver *pSat;
+    std::vector<int> vLits;
+
+  public:
+    GlucoseBackend() :
+      pSat(bmcg_sat_solver_start()) {
+    }
+
+    ~GlucoseBackend() {
+      bmcg_sat_solver_stop(pSat);
+    }
+
+    void Restart() override {
+      bmcg_sat_solver_reset(pSat);
+    }
+
+    int AddVar() override {
+      return bmcg_sat_solver_addvar(pSat);
+    }
+
+    int GetNumVars() override {
+      return bmcg_sat_solver_varnum(pSat);
+    }
+
+    bool AddClause(int const *pLits, int nLits) override {
+      vLits.assign(pLits, pLits + nLits);
+      return bmcg_sat_solver_addclause(pSat, vLits.data(), nLits);
+    }
+
+    SatResult Solve(int const *pLits, int nLits, int nConflictLimit) override {
+      vLits.assign(pLits, pLits + nLits);
+      bmcg_sat_solver_set_conflict_budget(pSat, nConflictLimit);
+      int res = bmcg_sat_solver_solve(pSat, vLits.data(), nLits);
+      if(res == GLUCOSE_SAT) {
+        return SAT;
+      }
+      if(res == GLUCOSE_UNSAT) {
+        return UNSAT;
+      }
+      return UNDET;
+    }
+
+    bool GetValue(int iVar) override {
+      return bmcg_sat_solver_read_cex_varvalue(pSat, iVar);
+    }
+
+    int GetNumConflicts() override {
+      return bmcg_sat_solver_conflictnum(pSat);
+    }
+
+    void GetCore(std::vector<int> &vCore) override {
+      int *pLits;
+      int nLits = bmcg_sat_solver_final(pSat, &pLits);
+      vCore.clear();
+      for(int i = 0; i < nLits; i++) {
+        vCore.push_back(lit_neg(pLits[i]));
+      }
+    }
+
+    void SetStop(int *pStop) override {
+      bmcg_sat_solver_set_stop(pSat, pStop);
+    }
+  };
+
+  /* }}} */
+
+  /* {{{ Satoko */
+
+  class SatokoBackend : public SatBackend {
+  private:
+    satoko_t *pSat;
+    std::vector<int> vLits;
+
+  public:
+    SatokoBackend() :
+      pSat(satoko_create()) {
+    }
+
+    ~SatokoBackend() {
+      satoko_destroy(pSat);
+    }
+
+    void Restart() override {
+      satoko_reset(pSat);
+    }
+
+    int AddVar() override {
+      return satoko_add_variable(pSat, 0);
+    }
+
+    int GetNumVars() override {
+      return satoko_varnum(pSat);
+    }
+
+    bool AddClause(int const *pLits, int nLits) override {
+      // satoko sorts literals in place
+      vLits.assign(pLits, pLits + nLits);
+      return satoko_add_clause(pSat, vLits.data(), nLits) == SATOKO_OK;
+    }
+
+    SatResult Solve(int const *pLits, int nLits, int nConflictLimit) override {
+      vLits.assign(pLits, pLits + nLits);
+      int res = satoko_solve_assumptions_limit(pSat, vLits.data(), nLits, nConflictLimit);
+      if(res == SATOKO_SAT) {
+        return SAT;
+      }
+      if(res == SATOKO_UNSAT) {
+        return UNSAT;
+      }
+      return UNDET;
+    }
+
+    bool GetValue(int iVar) override {
+      return satoko_read_cex_varvalue(pSat, iVar);
+    }
+
+    int GetNumConflicts() override {
+      return satoko_conflictnum(pSat);
+    }
+
+    void GetCore(std::vector<int> &vCore) override {
+      int *pLits;
+      int nLits = satoko_final_conflict(pSat, &pLits);
+      vCore.clear();
+      for(int i = 0; i < nLits; i++) {
+        vCore.push_back(lit_neg(pLits[i]));
+      }
+    }
+
+    void SetStop(int *pStop) override {
+      satoko_set_stop(pSat, pStop);
+    }
+  };
+
+  /* }}} */
+
+  inline SatBackend *CreateSatBackend(int nType) {
+    switch(nType) {
+    case 0:
+      return new BsatBackend;
+    case 1:
+      return new GlucoseBackend;
+    case 2:
+      return new SatokoBackend;
+    default:
+      std::cerr << "unknown SAT backend " << nType << std::endl;
+      std::abort();
+    }
+  }
+
+
+  /* {{{ Portfolio */
+
+  // queries unresolved within conflict limit are raced by main solver and helpers in parallel; first answer wins
+  // helpers are kept alongside main solver and given clauses logged since they were last used
+  // first helpers are of other types, and the rest see variables with signs flipped per helper to vary default polarity
+  class PortfolioBackend : public SatBackend {
+  private:
+    static constexpr int nTypes = 3; // backends created by CreateSatBackend
+    // helpers poll stop flag as plain int
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free, "atomic int must be laid out as int");
+
+    SatBackend *pMain;
+    SatBackend *pWinner; // solver that answered last query
+    int iWinner; // index of helper that answered last query (-1 if main)
+    int nType;
+    int nThreads;
+    int nConflictLimit;
+    int nVars;
+    int *pStop;
+    std::atomic<int> stop; // raised to stop helpers
+    std::vector<SatBackend *> vHelpers;
+    std::vector<char> vUnsats; // helpers whose clauses are trivially UNSAT
+    std::vector<int> vLog; // clauses not given to helpers yet, each preceded by its size
+    int nRaceConflicts; // conflicts of main solver in races, hidden from callers
+
+    // stats
+    int nCalls;
+    int nResolved;
+
+    // literal as seen by helper i (flipping is its own inverse)
+    int GetHelperLit(int i, int iLit) const {
+      if(i < nTypes - 1) {
+        return iLit;
+      }
+      unsigned x = ((unsigned)lit_var(iLit) ^ ((unsigned)i << 24)) * 0x9e3779b1u;
+      return iLit ^ (int)((x >> 16) & 1);
+    }
+
+  public:
+    PortfolioBackend(SatBackend *pMain, int nType, int nThreads, int nConflictLimit) :
+      pMain(pMain),
+      pWinner(pMain),
+      iWinner(-1),
+      nType(nType),
+      nThreads(nThreads),
+      nConflictLimit(nConflictLimit),
+      nVars(0),
+      pStop(NULL),
+      stop(0),
+      nRaceConflicts(0) {
+      ResetSummary();
+    }
+
+    ~PortfolioBackend() {
+      for(SatBackend *p: vHelpers) {
+        delete p;
+      }
+      delete pMain;
+    }
+
+    void Restart() override {
+      pWinner = pMain;
+      iWinner = -1;
+      nRaceConflicts = 0;
+      pMain->Restart();
+      for(SatBackend *p: vHelpers) {
+        p->Restart();
+      }
+      std::fill(vUnsats.begin(), vUnsats.end(), 0);
+      nVars = 0;
+      vLog.clear();
+    }
+
+    int AddVar() override {
+      nVars++;
+      return pMain->AddVar();
+    }
+
+    int GetNumVars() override {
+      return pMain->GetNumVars();
+    }
+
+    bool AddClause(int const *pLits, int nLits) override {
+      vLog.push_back(nLits);
+      vLog.insert(vLog.end(), pLits, pLits + nLits);
+      return pMain->AddClause(pLits, nLits);
+    }
+
+    SatResult Solve(int const *pLits, int nLits, int nConflictLimit_) override {
+      pWinner = pMain;
+      iWinner = -1;
+      SatResult res = pMain->Solve(pLits, nLits, nConflictLimit_);
+      if(res != UNDET || !nConflictLimit_ || (pStop && *pStop)) {
+        return res;
+      }
+      nCalls++;
+      if(vHelpers.empty()) {
+        for(int i = 0; i < nThreads; i++) {
+          vHelpers.push_back(CreateSatBackend((nType + 1 + i) % nTypes));
+          vHelpers.back()->SetStop(reinterpret_cast<int *>(&stop));
+        }
+        vUnsats.resize(nThreads);
+      }
+      stop = 0;
+      int iFirst = -2;
+      int nDone = 0;
+      std::mutex mtx;
+      auto Finish = [&](int i, SatResult r) {
+        std::lock_guard<std::mutex> lock(mtx);
+        nDone++;
+        if(r != UNDET && iFirst == -2) {
+          iFirst = i;
+          res = r;
+          stop = 1;
+        }
+      };
+      std::vector<std::thread> vThreads;
+      for(int i = 0; i < nThreads; i++) {
+        vThreads.emplace_back([&, i]() {
+          SatBackend *p = vHelpers[i];
+          std::vector<int> vLits;
+          while(p->GetNumVars() < nVars) {
+            p->AddVar();
+          }
+          for(int j = 0; !vUnsats[i] && j < int_size(vLog); j += vLog[j] + 1) {
+            vLits.clear();
+            for(int k = j + 1; k <= j + vLog[j]; k++) {
+              vLits.push_back(GetHelperLit(i, vLog[k]));
+            }
+            vUnsats[i] = !p->AddClause(vLits.data(), int_size(vLits));
+          }
+          vLits.clear();
+          for(int k = 0; k < nLits; k++) {
+            vLits.push_back(GetHelperLit(i, pLits[k]));
+          }
+          Finish(i, vUnsats[i]? UNSAT: p->Solve(vLits.data(), nLits, nConflictLimit));
+        });
+      }
+      // main solver continues with what it has learned instead of waiting
+      int nConflicts = pMain->GetNumConflicts();
+      pMain->SetStop(reinterpret_cast<int *>(&stop));
+      vThreads.emplace_back([&]() {
+        Finish(-1, pMain->Solve(pLits, nLits, nConflictLimit));
+      });
+      // solvers in race have internal flag, so external stop is relayed while waiting
+      while(pStop) {
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          if(nDone == nThreads + 1) {
+            break;
+          }
+        }
+        if(*pStop) {
+          stop = 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      for(std::thread &t: vThreads) {
+        t.join();
+      }
+      pMain->SetStop(pStop);
+      nRaceConflicts += pMain->GetNumConflicts() - nConflicts;
+      vLog.clear();
+      if(iFirst != -2) {
+        iWinner = iFirst;
+        pWinner = iWinner == -1? pMain: vHelpers[iWinner];
+        nResolved++;
+      }
+      return res;
+    }
+
+    bool GetValue(int iVar) override {
+      if(iWinner == -1) {
+        return pMain->GetValue(iVar);
+      }
+      return pWinner->GetValue(iVar) ^ (GetHelperLit(iWinner, toLitCond(iVar, 0)) & 1);
+    }
+
+    int GetNumConflicts() override {
+      return pMain->GetNumConflicts() - nRaceConflicts;
+    }
+
+    void GetCore(std::vector<int> &vCore) override {
+      pWinner->GetCore(vCore);
+      if(iWinner != -1) {
+        for(int &iLit: vCore) {
+          iLit = GetHelperLit(iWinner, iLit);
+        }
+      }
+    }
+
+    void SetStop(int *pStop_) override {
+      pStop = pStop_;
+      pMain->SetStop(pStop);
+    }
+
+    void ResetSummary() override {
+      nCalls = 0;
+      nResolved = 0;
+    }
+
+    summary<int> GetStatsSummary() const override {
+      summary<int> v;
+      v.emplace_back("sat portfolio call", nCalls);
+      v.emplace_back("sat portfolio resolved", nResolved);
+      return v;
+    }
+  };
+
+  /* }}} */
+
+  inline SatBackend *CreateSatBackend(Parameter const *pPar) {
+    SatBackend *p = CreateSatBackend(pPar->nSatBackend);
+    if(pPar->nSatPortfolio) {
+      p = new PortfolioBackend(p, pPar->nSatBackend, pPar->nSatPortfolio, pPar->nSatPortfolioConflictLimit);
+    }
+    return p;
+  }
+
+}
@@ -4,6 +4,7 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "rrrSatBackend.h"
 
 ABC_NAMESPACE_USING_NAMESPACE
 
@@ -21,6 +22,7 @@ namespace rrr {
 
     // data
     sat_solver *pSat;
+    int *pStop; // queries are given up once this becomes nonzero
     bool status; // false indicates trivial UNSAT
     int  target; // node for which miter has been encoded
     std::vector<int> vVars; // SAT variable for each node
@@ -48,13 +50,17 @@ namespace rrr {
     SatSolver(Parameter const *pPar);
     ~SatSolver();
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop_);
     
     // checks
     SatResult CheckRedundancy(int id, int idx);
     SatResult CheckFeasibility(int id, int fi, bool c);
+    SatResult CheckRedundantFanins(int id, std::vector<int> &vIdxs);
 
     // cex
     std::vector<VarValue> GetCex();
+    bool HarvestCex();
 
     // stats
     void ResetSummary();
@@ -269,6 +275,7 @@ namespace rrr {
     nVerbose(pPar->nSatSolverVerbose),
     nConflictLimit(pPar->nConflictLimit),
     pSat(sat_solver_new()),
+    pStop(NULL),
     status(false),
     target(-1),
     fUpdate(false) {
@@ -291,6 +298,16 @@ namespace rrr {
     pNtk->AddCallback(std::bind(&SatSolver<Ntk>::ActionCallback, this, std::placeholders::_1));
   }
 
+  template <typename Ntk>
+  void SatSolver<Ntk>::SetTimeBudget(time_point, seconds) {
+  }
+
+  template <typename Ntk>
+  void SatSolver<Ntk>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    sat_solver_set_stop_func(pSat, pStop? BsatStopFunc: NULL);
+  }
+
   /* }}} */
 
   /* {{{ Checks */
@@ -325,6 +342,7 @@ namespace rrr {
       std::cout << std::endl;
     }
     nCalls++;
+    BsatStopFlag() = pStop;
     int res = sat_solver_solve(pSat, vLits.data(), vLits.data() + vLits.size(), nConflictLimit, 0 /*nInsLimit*/, 0 /*nConfLimitGlobal*/, 0 /*nInsLimitGlobal*/);
     if(res == l_False) {
       if(nVerbose) {
@@ -396,6 +414,7 @@ namespace rrr {
       std::cout << std::endl;
     }
     nCalls++;
+    BsatStopFlag() = pStop;
     int res = sat_solver_solve(pSat, vLits.data(), vLits.data() + vLits.size(), nConflictLimit, 0 /*nInsLimit*/, 0 /*nConfLimitGlobal*/, 0 /*nInsLimitGlobal*/);
     if(res == l_False) {
       if(nVerbose) {
@@ -441,6 +460,12 @@ namespace rrr {
     durationFeasibility += Duration(timeStart, GetCurrentTime());
     return SAT;
   }
+
+  template <typename Ntk>
+  SatResult SatSolver<Ntk>::CheckRedundantFanins(int, std::vector<int> &) {
+    // not supported
+    return UNDET;
+  }
   
   /* }}} */
 
@@ -555,6 +580,12 @@ namespace rrr {
     return vPartialCex;
   }
 
+  template <typename Ntk>
+  bool SatSolver<Ntk>::HarvestCex() {
+    // not supported
+    return false;
+  }
+
   /* }}} */
 
   /* {{{ Stats */
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <sat/bsat/satSolver.h>
+#include <map>
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
-
-ABC_NAMESPACE_USING_NAMESPACE
+#include "rrrSatBackend.h"
+#include "rrrConflictBudget.h"
 
 namespace rrr {
 
@@ -17,47 +17,103 @@ namespace rrr {
 
     // parameters
     int nVerbose;
-    int nConflictLimit;
+    int nWindowDepth;
+    int nCexes;
+    int nCacheSize;
+    static constexpr int nRestartRatio = 4; // restart solver when variables exceed this many times nodes
 
     // data
-    sat_solver *pSat;
+    SatBackend *pSat;
+    ConflictBudget budget;
+    int *pStop; // queries are given up once this becomes nonzero
     bool status; // false indicates trivial UNSAT
     int  target; // node for which miter has been encoded
-    std::vector<int> vVars; // SAT variable for each node
+    int  iActivation; // variable enabling miter output clause (-1 if none)
+    std::vector<int> vVars; // SAT variable for each node (-1 if not encoded), kept across targets
     std::vector<int> vVars2; // SAT variable for each node for inverted copy
+    std::vector<int> vOutputs; // outputs of miter
+    std::vector<int> vDepths; // depth from target in TFO window (-1 if outside)
+    std::vector<int> vNodes; // temporary storage
     std::vector<int> vLits; // temporary storage
+    std::vector<int> vFaninLits; // temporary storage
     std::vector<VarValue> vValues; // values in satisfied problem
     std::vector<VarValue> vValues2; // values in satisfied problem for inverted copy
+    std::vector<int> vUpdates; // nodes whose functions have been modified since last encoding
     bool fUpdate;
+    bool fReset;
+    int  iBlocking; // variable enabling blocking clauses of harvested cexes (-1 if none)
+    int  nHarvested; // number of cexes harvested from current SAT result
+    std::vector<int> vAssumptions; // assumptions of last satisfied problem
+    std::vector<int> vRequired; // nodes whose values are required in last satisfied problem
+    std::vector<VarValue> vCex; // last partial cex
+
+    // cache
+    std::vector<int> vSids; // structure id of TFI of each node (-1 if outdated)
+    std::vector<int> vSidUpdates; // nodes whose fanins have been modified since structure ids were computed
+    std::map<std::vector<int>, int> mapSids; // node and its fanin edges over structure ids -> structure id
+    int iConeTarget; // node for which cone key has been computed (-1 if outdated)
+    std::vector<int> vConeKey;
+    std::map<std::vector<int>, std::pair<SatResult, std::vector<VarValue>>> mapCache; // query -> result and cex
+    std::vector<int> vPendingKey; // query to be stored once its result is known
+    bool fPending;
+    bool fCached; // last result was from cache
 
     // stats
     int nCalls;
     int nSats;
     int nUnsats;
+    int nRestarts;
+    int nHarvests;
+    int nHarvestedCexes;
+    int nCoreCalls;
+    int nCacheHits;
     double durationRedundancy;
     double durationFeasibility;
 
     // callback
     void ActionCallback(Action const &action);
+    void SidActionCallback(Action const &action);
 
     // encode
-    void EncodeNode(sat_solver *p, std::vector<int> const &v, int id, int to_negate = -1) const;
-    void EncodeMiter(sat_solver *p, std::vector<int> &v, std::vector<int> &v2, int id); // create a careset miter where the counterpart has the output of target negated
+    void EncodeNode(SatBackend *p, std::vector<int> const &v, int id, int to_negate = -1); // n-ary and without intermediate variables
+    void EncodeTfi(SatBackend *p, std::vector<int> &v, std::vector<int> &v2, int id); // encode TFI of node on demand, shared by both copies
+    void CollectWindow(int id, std::vector<int> &vTfo, std::vector<int> &vOuts); // TFO of target within window and its outputs
+    void EncodeMiter(SatBackend *p, std::vector<int> &v, std::vector<int> &v2, int id); // create a careset miter where the counterpart has the output of target negated
+    void UpdateVars();
     void SetTarget(int id);
+
+    // solve
+    SatResult Solve(); // under assumptions in vLits with limit from budget
+
+    // cache
+    void UpdateSids();
+    int GetSid(int id);
+    std::vector<int> const &GetConeKey(int id); // everything miter of target depends on
+    bool LookupCache(SatResult &res); // for query in vPendingKey
+    void StoreCache(SatResult res);
+
+    // values
+    void ReadValues();
+    void DecideRequired();
+    void RetireBlocking();
     
   public:
     // constructors
     SatSolver2(Parameter const *pPar);
     ~SatSolver2();
     void AssignNetwork(Ntk *pNtk_, bool fReuse);
+    void SetTimeBudget(time_point start, seconds nTimeout); // 0 = no limit
+    void SetStop(int *pStop_);
     
     // checks
     SatResult CheckRedundancy(int id, int idx);
     SatResult CheckFeasibility(int id, int fi, bool c);
+    SatResult CheckRedundantFanins(int id, std::vector<int> &vIdxs); // whether fanins other than those kept are removable together; kept ones are reduced to UNSAT core, or extended by controlling ones in cex
 
     // cex
     void Justify(std::vector<VarValue> &v, int id);
     std::vector<VarValue> GetCex();
+    bool HarvestCex(); // finds another assignment of last satisfied problem that differs from previous cexes, then GetCex can be called
 
     // stats
     void ResetSummary();
@@ -69,31 +125,54 @@ namespace rrr {
 
   template <typename Ntk>
   void SatSolver2<Ntk>::ActionCallback(Action const &action) {
-    if(target == -1) {
-      return;
+    if(nCacheSize) {
+      SidActionCallback(action);
     }
+    // encodings of removed nodes are left in solver as their variables become unreachable
     switch(action.type) {
     case REMOVE_FANIN:
+      vUpdates.push_back(action.id);
       if(action.id != target) {
         fUpdate = true;
       }
       break;
     case REMOVE_UNUSED:
+      if(action.id < int_size(vVars)) {
+        vVars[action.id] = -1;
+      }
       break;
     case REMOVE_BUFFER:
     case REMOVE_CONST:
       if(action.id == target) {
         target = -1;
       }
+      if(action.id < int_size(vVars)) {
+        vVars[action.id] = -1;
+      }
+      if(std::find(vUpdates.begin(), vUpdates.end(), action.id) != vUpdates.end()) {
+        // fanouts refer to outdated encoding
+        vUpdates.insert(vUpdates.end(), action.vFanouts.begin(), action.vFanouts.end());
+      }
       break;
     case ADD_FANIN:
+      vUpdates.push_back(action.id);
       if(action.id != target) {
         fUpdate = true;
       }
       break;
     case TRIVIAL_COLLAPSE:
+      if(action.fi < int_size(vVars)) {
+        vVars[action.fi] = -1;
+      }
+      if(std::find(vUpdates.begin(), vUpdates.end(), action.fi) != vUpdates.end()) {
+        vUpdates.push_back(action.id);
+      }
       break;
     case TRIVIAL_DECOMPOSE:
+      if(action.fi < int_size(vVars)) {
+        vVars[action.fi] = -1;
+      }
+      vUpdates.push_back(action.id); // new fanin is not encoded
       fUpdate = true; // necessary if function or don't care of new edge needs to be considered
       break;
     case SORT_FANINS:
@@ -102,11 +181,15 @@ namespace rrr {
       status = false;
       target = -1;
       fUpdate = false;
+      fReset = true;
+      vUpdates.clear();
       break;
     case SAVE:
       break;
     case LOAD:
       target = -1;
+      std::fill(vVars.begin(), vVars.end(), -1);
+      vUpdates.clear();
       break;
     case POP_BACK:
       break;
@@ -115,116 +198,217 @@ namespace rrr {
     }
   }
 
+  template <typename Ntk>
+  void SatSolver2<Ntk>::SidActionCallback(Action const &action) {
+    // structure ids of TFO of nodes with modified fanins are cleared lazily
+    iConeTarget = -1;
+    switch(action.type) {
+    case REMOVE_FANIN:
+    case ADD_FANIN:
+    case SORT_FANINS:
+      vSidUpdates.push_back(action.id);
+      break;
+    case REMOVE_UNUSED:
+      if(action.id < int_size(vSids)) {
+        vSids[action.id] = -1;
+      }
+      break;
+    case REMOVE_BUFFER:
+    case REMOVE_CONST:
+      if(action.id < int_size(vSids)) {
+        vSids[action.id] = -1;
+      }
+      vSidUpdates.insert(vSidUpdates.end(), action.vFanouts.begin(), action.vFanouts.end());
+      break;
+    case TRIVIAL_COLLAPSE:
+    case TRIVIAL_DECOMPOSE:
+      if(action.fi < int_size(vSids)) {
+        vSids[action.fi] = -1;
+      }
+      vSidUpdates.push_back(action.id);
+      break;
+    case READ:
+    case LOAD:
+      std::fill(vSids.begin(), vSids.end(), -1);
+      vSidUpdates.clear();
+      break;
+    default:
+      break;
+    }
+  }
+
   /* }}} */
   
   /* {{{ Encode */
 
   template <typename Ntk>
-  void SatSolver2<Ntk>::EncodeNode(sat_solver *p, std::vector<int> const &v, int id, int to_negate) const {
-    int RetValue;
-    int x = -1, y = -1;
-    bool cx = false, cy = false;
+  void SatSolver2<Ntk>::EncodeNode(SatBackend *p, std::vector<int> const &v, int id, int to_negate) {
     assert(pNtk->GetNodeType(id) == AND);
-    std::string delim;
-    if(nVerbose) {
-      std::cout << "node " << std::setw(3) << id << ": ";
-    }
+    vFaninLits.clear();
     pNtk->ForEachFanin(id, [&](int fi, bool c) {
-      if(x == -1) {
-        x = v[fi];
-        cx = c ^ (fi == to_negate);
-      } else if(y == -1) {
-        y = v[fi];
-        cy = c ^ (fi == to_negate);
-      } else {
-        int z = sat_solver_addvar(p);
-        if(nVerbose) {
-          std::cout << delim << z << " = " << (cx? "!": "") << x << " & " << (cy? "!": "") << y << std::endl;
-          delim = std::string(10, ' ');
-        }
-        RetValue = sat_solver_add_and(p, z, x, y, cx, cy, 0);
-        assert(RetValue);
-        x = z;
-        cx = false;
-        y = v[fi];
-        cy = c ^ (fi == to_negate);
-      }
+      vFaninLits.push_back(toLitCond(v[fi], c ^ (fi == to_negate)));
     });
-    if(x == -1) {
-      if(nVerbose) {
-        std::cout << delim << v[id] << " = !0" << std::endl;
+    if(nVerbose) {
+      std::cout << "node " << std::setw(3) << id << ": " << v[id] << " = ";
+      if(vFaninLits.empty()) {
+        std::cout << "!0";
       }
-      RetValue = sat_solver_add_const(p, v[id], 0);
-      assert(RetValue);
-    } else if(y == -1) {
-      if(nVerbose) {
-        std::cout << delim << v[id] << " = " << (cx? "!": "") << x << std::endl;
+      std::string delim;
+      for(int iLit: vFaninLits) {
+        std::cout << delim << (lit_sign(iLit)? "!": "") << lit_var(iLit);
+        delim = " & ";
       }
-      RetValue = sat_solver_add_buffer(p, v[id], x, cx);
-      assert(RetValue);
+      std::cout << std::endl;
+    }
+    if(vFaninLits.empty()) {
+      p->AddConst(v[id], 0);
+    } else if(int_size(vFaninLits) == 1) {
+      p->AddBuffer(v[id], lit_var(vFaninLits[0]), lit_sign(vFaninLits[0]));
     } else {
-      if(nVerbose) {
-        std::cout << delim << v[id] << " = " << (cx? "!": "") << x << " & " << (cy? "!": "") << y << std::endl;
+      p->AddAnd(v[id], vFaninLits);
+    }
+  }
+  
+  template <typename Ntk>
+  void SatSolver2<Ntk>::EncodeTfi(SatBackend *p, std::vector<int> &v, std::vector<int> &v2, int id) {
+    if(v[id] != -1) {
+      return;
+    }
+    v[id] = v2[id] = p->AddVar();
+    if(pNtk->IsPi(id)) {
+      return;
+    }
+    vNodes.clear();
+    vNodes.push_back(id);
+    pNtk->ForEachTfiUpdate(id, true, [&](int fi) {
+      if(v[fi] != -1) {
+        return false;
       }
-      RetValue = sat_solver_add_and(p, v[id], x, y, cx, cy, 0);
-      assert(RetValue);
+      v[fi] = v2[fi] = p->AddVar();
+      if(pNtk->IsInt(fi)) {
+        vNodes.push_back(fi);
+      }
+      return true;
+    });
+    for(int i = int_size(vNodes) - 1; i >= 0; i--) {
+      EncodeNode(p, v, vNodes[i]);
     }
   }
   
   template <typename Ntk>
-  void SatSolver2<Ntk>::EncodeMiter(sat_solver *p, std::vector<int> &v, std::vector<int> &v2, int id) {
-    int RetValue;
-    // reset
-    v.clear();
-    sat_solver_restart(p);
-    status = true;
-    // assign vars for the base
+  void SatSolver2<Ntk>::CollectWindow(int id, std::vector<int> &vTfo, std::vector<int> &vOuts) {
+    // collect TFO within window, whose outputs are POs or nodes with fanouts outside window
     int nNodes = pNtk->GetNumNodes();
-    sat_solver_setnvars(p, nNodes);
-    v.resize(nNodes);
-    for(int i = 0; i < nNodes; i++) {
-      v[i] = i;
+    if(int_size(vDepths) < nNodes) {
+      vDepths.resize(nNodes, -1);
     }
+    vTfo.clear();
+    vOuts.clear();
+    vDepths[id] = 0;
+    pNtk->ForEachTfoUpdate(id, false, [&](int fo) {
+      int d = -1;
+      pNtk->ForEachFanin(fo, [&](int fi) {
+        if(vDepths[fi] != -1 && (d == -1 || vDepths[fi] + 1 < d)) {
+          d = vDepths[fi] + 1;
+        }
+      });
+      assert(d != -1);
+      if(nWindowDepth && d > nWindowDepth) {
+        return false;
+      }
+      vDepths[fo] = d;
+      vTfo.push_back(fo);
+      return true;
+    });
+    for(int fo: vTfo) {
+      bool fOutput = pNtk->IsPoDriver(fo);
+      if(!fOutput) {
+        pNtk->ForEachFanout(fo, false, [&](int fo2) {
+          if(vDepths[fo2] == -1) {
+            fOutput = true;
+          }
+        });
+      }
+      if(fOutput) {
+        vOuts.push_back(fo);
+      }
+    }
+    vDepths[id] = -1;
+    for(int fo: vTfo) {
+      vDepths[fo] = -1;
+    }
+  }
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::EncodeMiter(SatBackend *p, std::vector<int> &v, std::vector<int> &v2, int id) {
+    bool RetValue;
+    int nNodes = pNtk->GetNumNodes();
+    // restart once retired encodings dominate
+    if(fReset || p->GetNumVars() > nRestartRatio * nNodes) {
+      if(nVerbose) {
+        std::cout << "restarting solver" << std::endl;
+      }
+      p->Restart();
+      std::fill(v.begin(), v.end(), -1);
+      iActivation = -1;
+      iBlocking = -1;
+      fReset = false;
+      nRestarts++;
+    }
+    // retire previous miter
+    if(iActivation != -1) {
+      int iLit = toLitCond(iActivation, 1);
+      RetValue = p->AddClause(&iLit, 1);
+      assert(RetValue);
+      iActivation = -1;
+    }
+    status = true;
+    vOutputs.clear();
     // constrain const-0
-    RetValue = sat_solver_add_const(p, v[0], 1);
-    assert(RetValue);
-    // encode first circuit
-    if(nVerbose) {
-      std::cout << "encoding network" << std::endl;
+    if(v[0] == -1) {
+      v[0] = p->AddVar();
+      p->AddConst(v[0], 1);
     }
-    pNtk->ForEachInt([&](int id) {
-      EncodeNode(p, v, id);
-    });
     v2 = v;
     // always care if it is po
     if(pNtk->IsPoDriver(id)) {
+      if(nVerbose) {
+        std::cout << "encoding network" << std::endl;
+      }
+      EncodeTfi(p, v, v2, id);
       return;
     }
+    std::vector<int> vTfo;
+    CollectWindow(id, vTfo, vOutputs);
+    // encode first circuit only in TFI of outputs
+    if(nVerbose) {
+      std::cout << "encoding network" << std::endl;
+    }
+    for(int fo: vOutputs) {
+      EncodeTfi(p, v, v2, fo);
+    }
     // encode an inverted copy
     if(nVerbose) {
       std::cout << "encoding an inverted copy" << std::endl;
     }
-    pNtk->ForEachTfo(id, false, [&](int fo) {
-      v2[fo] = sat_solver_addvar(p);
+    for(int fo: vTfo) {
+      assert(v[fo] != -1);
+      v2[fo] = p->AddVar();
       EncodeNode(p, v2, fo, id);
-    });
+    }
     // encode miter xors
     if(nVerbose) {
       std::cout << "encoding miter xors" << std::endl;
     }
     vLits.clear();
-    pNtk->ForEachPoDriver([&](int fi) {
-      assert(fi != id);
-      if(v[fi] != v2[fi]) {
-        int x = sat_solver_addvar(p);
-        if(nVerbose) {
-          std::cout << x << " = " << v[fi] << " ^ " << v2[fi] << std::endl;
-        }
-        RetValue = sat_solver_add_xor(p, x, v[fi], v2[fi], 0);
-        assert(RetValue);
-        vLits.push_back(toLitCond(x, 0));
+    for(int fo: vOutputs) {
+      int x = p->AddVar();
+      if(nVerbose) {
+        std::cout << x << " = " << v[fo] << " ^ " << v2[fo] << std::endl;
       }
-    });
+      p->AddXor(x, v[fo], v2[fo]);
+      vLits.push_back(toLitCond(x, 0));
+    }
     // assign or of xors to 1
     if(nVerbose) {
       std::cout << "adding miter output clause" << std::endl;
@@ -240,10 +424,32 @@ namespace rrr {
       status = false;
       return;
     }
-    RetValue = sat_solver_addclause(p, vLits.data(), vLits.data() + vLits.size());
+    // miter output is enabled only under activation literal
+    iActivation = p->AddVar();
+    vLits.push_back(toLitCond(iActivation, 1));
+    RetValue = p->AddClause(vLits.data(), int_size(vLits));
     assert(RetValue);
   }
 
+  template <typename Ntk>
+  void SatSolver2<Ntk>::UpdateVars() {
+    // re-encode modified nodes and their TFOs with new variables
+    vVars.resize(pNtk->GetNumNodes(), -1);
+    vNodes.clear();
+    for(int id: vUpdates) {
+      if(pNtk->IsInt(id)) {
+        vNodes.push_back(id);
+      }
+    }
+    vUpdates.clear();
+    if(vNodes.empty()) {
+      return;
+    }
+    pNtk->ForEachTfos(vNodes, false, [&](int id) {
+      vVars[id] = -1;
+    });
+  }
+
   template <typename Ntk>
   void SatSolver2<Ntk>::SetTarget(int id) {
     if(!fUpdate && id == target) {
@@ -251,28 +457,186 @@ namespace rrr {
     }
     fUpdate = false;
     target = id;
+    UpdateVars();
     EncodeMiter(pSat, vVars, vVars2, target);
   }
 
   /* }}} */
 
+  /* {{{ Solve */
+
+  template <typename Ntk>
+  SatResult SatSolver2<Ntk>::Solve() {
+    for(int iRetry = 0;; iRetry++) {
+      if(pStop && *pStop) {
+        return UNDET;
+      }
+      int nLimit = budget.GetLimit(iRetry);
+      int nConflicts = pSat->GetNumConflicts();
+      time_point timeStart = GetCurrentTime();
+      SatResult res = pSat->Solve(vLits.data(), int_size(vLits), nLimit);
+      budget.Record(res, pSat->GetNumConflicts() - nConflicts, nLimit, Duration(timeStart, GetCurrentTime()), iRetry);
+      if(res != UNDET || !budget.Retry(iRetry)) {
+        return res;
+      }
+      if(nVerbose) {
+        std::cout << "retrying with escalated conflict limit" << std::endl;
+      }
+    }
+  }
+
+  /* }}} */
+
+  /* {{{ Cache */
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::UpdateSids() {
+    vSids.resize(pNtk->GetNumNodes(), -1);
+    vNodes.clear();
+    for(int id: vSidUpdates) {
+      if(pNtk->IsInt(id)) {
+        vNodes.push_back(id);
+      }
+    }
+    vSidUpdates.clear();
+    if(vNodes.empty()) {
+      return;
+    }
+    pNtk->ForEachTfos(vNodes, false, [&](int id) {
+      vSids[id] = -1;
+    });
+  }
+
+  template <typename Ntk>
+  int SatSolver2<Ntk>::GetSid(int id) {
+    // ids are given by unique table like structural hashing, so equal ids mean identical TFIs
+    if(!pNtk->IsInt(id)) {
+      return -2 - id;
+    }
+    if(vSids[id] != -1) {
+      return vSids[id];
+    }
+    // compute outdated ones in topological order
+    vNodes.clear();
+    vNodes.push_back(id);
+    pNtk->ForEachTfiUpdate(id, false, [&](int fi) {
+      if(vSids[fi] != -1) {
+        return false;
+      }
+      vNodes.push_back(fi);
+      return true;
+    });
+    std::vector<int> vKey;
+    for(int i = int_size(vNodes) - 1; i >= 0; i--) {
+      vKey.clear();
+      vKey.push_back(vNodes[i]);
+      pNtk->ForEachFanin(vNodes[i], [&](int fi, bool c) {
+        vKey.push_back(pNtk->IsInt(fi)? vSids[fi]: -2 - fi);
+        vKey.push_back(c);
+      });
+      std::map<std::vector<int>, int>::const_iterator it = mapSids.emplace(vKey, int_size(mapSids)).first;
+      vSids[vNodes[i]] = it->second;
+    }
+    return vSids[id];
+  }
+
+  template <typename Ntk>
+  std::vector<int> const &SatSolver2<Ntk>::GetConeKey(int id) {
+    if(id == iConeTarget) {
+      return vConeKey;
+    }
+    vConeKey.clear();
+    vConeKey.push_back(id);
+    if(pNtk->IsPoDriver(id)) {
+      vConeKey.push_back(1);
+      vConeKey.push_back(GetSid(id));
+    } else {
+      // window and its outputs, whose TFIs cover the rest
+      std::vector<int> vTfo, vOuts;
+      CollectWindow(id, vTfo, vOuts);
+      vConeKey.push_back(0);
+      vConeKey.push_back(int_size(vOuts));
+      for(int fo: vOuts) {
+        vConeKey.push_back(fo);
+        vConeKey.push_back(GetSid(fo));
+      }
+    }
+    iConeTarget = id;
+    return vConeKey;
+  }
+
+  template <typename Ntk>
+  bool SatSolver2<Ntk>::LookupCache(SatResult &res) {
+    std::map<std::vector<int>, std::pair<SatResult, std::vector<VarValue>>>::const_iterator it = mapCache.find(vPendingKey);
+    if(it == mapCache.end()) {
+      fPending = true;
+      return false;
+    }
+    if(nVerbose) {
+      std::cout << "found in cache" << std::endl;
+    }
+    res = it->second.first;
+    if(res == SAT) {
+      vCex = it->second.second;
+      fCached = true;
+    }
+    nCacheHits++;
+    return true;
+  }
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::StoreCache(SatResult res) {
+    if(!fPending) {
+      return;
+    }
+    fPending = false;
+    if(int_size(mapCache) >= nCacheSize || int_size(mapSids) >= 16 * nCacheSize + pNtk->GetNumNodes()) {
+      // stale structures are dropped together with queries over them, including pending one
+      mapCache.clear();
+      mapSids.clear();
+      vSids.clear();
+      vSids.resize(pNtk->GetNumNodes(), -1);
+      vSidUpdates.clear();
+      iConeTarget = -1;
+      return;
+    }
+    if(res == SAT) {
+      mapCache[vPendingKey] = std::make_pair(res, vCex);
+    } else {
+      mapCache[vPendingKey] = std::make_pair(res, std::vector<VarValue>());
+    }
+  }
+
+  /* }}} */
+
   /* {{{ Constructors */
 
   template <typename Ntk>
   SatSolver2<Ntk>::SatSolver2(Parameter const *pPar) :
     pNtk(NULL),
     nVerbose(pPar->nSatSolverVerbose),
-    nConflictLimit(pPar->nConflictLimit),
-    pSat(sat_solver_new()),
+    nWindowDepth(pPar->nSatWindowDepth),
+    nCexes(std::min(pPar->nSatCexes, 63)),
+    nCacheSize(pPar->nSatCacheSize),
+    pSat(CreateSatBackend(pPar)),
+    budget(pPar),
+    pStop(NULL),
     status(false),
     target(-1),
-    fUpdate(false) {
+    iActivation(-1),
+    fUpdate(false),
+    fReset(false),
+    iBlocking(-1),
+    nHarvested(0),
+    iConeTarget(-1),
+    fPending(false),
+    fCached(false) {
     ResetSummary();
   }
 
   template <typename Ntk>
   SatSolver2<Ntk>::~SatSolver2() {
-    sat_solver_delete(pSat);
+    delete pSat;
     //std::cout << "SAT solver stats: calls = " << nCalls << " (SAT = " << nSats << ", UNSAT = " << nUnsats << ", UNDET = " << nCalls - nSats - nUnsats << ")" << std::endl;
   }
 
@@ -282,10 +646,31 @@ namespace rrr {
     status = false;
     target = -1;
     fUpdate = false;
+    fReset = true;
+    iBlocking = -1;
+    budget.Reset();
+    vVars.clear();
+    vSids.clear();
+    vSidUpdates.clear();
+    mapSids.clear();
+    iConeTarget = -1;
+    mapCache.clear();
+    vUpdates.clear();
     pNtk = pNtk_;
     pNtk->AddCallback(std::bind(&SatSolver2<Ntk>::ActionCallback, this, std::placeholders::_1));
   }
 
+  template <typename Ntk>
+  void SatSolver2<Ntk>::SetTimeBudget(time_point start, seconds nTimeout) {
+    budget.SetTimeBudget(start, nTimeout);
+  }
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    pSat->SetStop(pStop);
+  }
+
   /* }}} */
 
   /* {{{ Checks */
@@ -293,15 +678,33 @@ namespace rrr {
   template <typename Ntk>
   SatResult SatSolver2<Ntk>::CheckRedundancy(int id, int idx) {
     time_point timeStart = GetCurrentTime();
+    RetireBlocking();
+    fPending = false;
+    fCached = false;
+    if(nCacheSize) {
+      SatResult res;
+      UpdateSids();
+      vPendingKey = GetConeKey(id);
+      vPendingKey.push_back(0);
+      vPendingKey.push_back(idx);
+      if(LookupCache(res)) {
+        durationRedundancy += Duration(timeStart, GetCurrentTime());
+        return res;
+      }
+    }
     SetTarget(id);
     if(!status) {
       if(nVerbose) {
         std::cout << "trivially UNSATISFIABLE" << std::endl;
       }
+      StoreCache(UNSAT);
       durationRedundancy += Duration(timeStart, GetCurrentTime());
       return UNSAT;
     }
     vLits.clear();
+    if(iActivation != -1) {
+      vLits.push_back(toLit(iActivation));
+    }
     assert(pNtk->GetNodeType(id) == AND);    
     pNtk->ForEachFaninIdx(id, [&](int idx2, int fi, bool c) {
       if(idx == idx2) {
@@ -320,56 +723,40 @@ namespace rrr {
       std::cout << std::endl;
     }
     nCalls++;
-    int res = sat_solver_solve(pSat, vLits.data(), vLits.data() + vLits.size(), nConflictLimit, 0 /*nInsLimit*/, 0 /*nConfLimitGlobal*/, 0 /*nInsLimitGlobal*/);
-    if(res == l_False) {
+    SatResult res = Solve();
+    if(res == UNSAT) {
       if(nVerbose) {
         std::cout << "UNSATISFIABLE" << std::endl;
       }
       nUnsats++;
+      StoreCache(UNSAT);
       durationRedundancy += Duration(timeStart, GetCurrentTime());
       return UNSAT;
     }
-    if(res == l_Undef) {
+    if(res == UNDET) {
       if(nVerbose) {
         std::cout << "UNDETERMINED" << std::endl;
       }
+      fPending = false;
       durationRedundancy += Duration(timeStart, GetCurrentTime());
       return UNDET;
     }
-    assert(res == l_True);
+    assert(res == SAT);
     if(nVerbose) {
       std::cout << "SATISFIABLE" << std::endl;
     }
     nSats++;
-    vValues.clear();
-    vValues.resize(pNtk->GetNumNodes());
-    pNtk->ForEachPi([&](int id) {
-      if(sat_solver_var_value(pSat, vVars[id])) {
-        vValues[id] = TEMP_TRUE;
-      } else {
-        vValues[id] = TEMP_FALSE;
-      }
-    });
-    vValues2 = vValues;
-    pNtk->ForEachInt([&](int id) {
-      if(sat_solver_var_value(pSat, vVars[id])) {
-        vValues[id] = TEMP_TRUE;
-      } else {
-        vValues[id] = TEMP_FALSE;
-      }
-      if(sat_solver_var_value(pSat, vVars2[id])) {
-        vValues2[id] = TEMP_TRUE;
-      } else {
-        vValues2[id] = TEMP_FALSE;
-      }
-    });
+    ReadValues();
     // required values
     // TODO: maybe this should be done at POs
+    vAssumptions = vLits;
+    vRequired.clear();
+    nHarvested = 0;
     pNtk->ForEachFaninIdx(id, [&](int idx2, int fi, bool c) {
       assert((vValues[fi] == TEMP_TRUE) ^ (idx == idx2) ^ c);
-      vValues[fi] = DecideVarValue(vValues[fi]);
-      vValues2[fi] = DecideVarValue(vValues2[fi]);
+      vRequired.push_back(fi);
     });
+    DecideRequired();
     durationRedundancy += Duration(timeStart, GetCurrentTime());
     return SAT;
   }
@@ -377,15 +764,35 @@ namespace rrr {
   template <typename Ntk>
   SatResult SatSolver2<Ntk>::CheckFeasibility(int id, int fi, bool c) {
     time_point timeStart = GetCurrentTime();
+    RetireBlocking();
+    fPending = false;
+    fCached = false;
+    if(nCacheSize) {
+      SatResult res;
+      UpdateSids();
+      vPendingKey = GetConeKey(id);
+      vPendingKey.push_back(1);
+      vPendingKey.push_back(GetSid(fi));
+      vPendingKey.push_back(c);
+      if(LookupCache(res)) {
+        durationFeasibility += Duration(timeStart, GetCurrentTime());
+        return res;
+      }
+    }
     SetTarget(id);
     if(!status) {
       if(nVerbose) {
         std::cout << "trivially UNSATISFIABLE" << std::endl;
       }
+      StoreCache(UNSAT);
       durationFeasibility += Duration(timeStart, GetCurrentTime());
       return UNSAT;
     }
+    EncodeTfi(pSat, vVars, vVars2, fi);
     vLits.clear();
+    if(iActivation != -1) {
+      vLits.push_back(toLit(iActivation));
+    }
     assert(pNtk->GetNodeType(id) == AND);
     vLits.push_back(toLit(vVars[id]));
     vLits.push_back(toLitCond(vVars[fi], !c));
@@ -399,31 +806,150 @@ namespace rrr {
       std::cout << std::endl;
     }
     nCalls++;
-    int res = sat_solver_solve(pSat, vLits.data(), vLits.data() + vLits.size(), nConflictLimit, 0 /*nInsLimit*/, 0 /*nConfLimitGlobal*/, 0 /*nInsLimitGlobal*/);
-    if(res == l_False) {
+    SatResult res = Solve();
+    if(res == UNSAT) {
       if(nVerbose) {
         std::cout << "UNSATISFIABLE" << std::endl;
       }
       nUnsats++;
+      StoreCache(UNSAT);
       durationFeasibility += Duration(timeStart, GetCurrentTime());
       return UNSAT;
     }
-    if(res == l_Undef) {
+    if(res == UNDET) {
       if(nVerbose) {
         std::cout << "UNDETERMINED" << std::endl;
       }
+      fPending = false;
       durationFeasibility += Duration(timeStart, GetCurrentTime());
       return UNDET;
     }
-    assert(res == l_True);
+    assert(res == SAT);
+    if(nVerbose) {
+      std::cout << "SATISFIABLE" << std::endl;
+    }
+    nSats++;
+    ReadValues();
+    // required values
+    // TODO: maybe this should be done at POs
+    assert(vValues[id] == TEMP_TRUE);
+    assert(vValues2[id] == TEMP_TRUE);
+    assert((vValues[fi] == TEMP_TRUE) ^ !c);
+    assert((vValues2[fi] == TEMP_TRUE) ^ !c);
+    vAssumptions = vLits;
+    vRequired.clear();
+    vRequired.push_back(id);
+    vRequired.push_back(fi);
+    nHarvested = 0;
+    DecideRequired();
+    durationFeasibility += Duration(timeStart, GetCurrentTime());
+    return SAT;
+  }
+
+  template <typename Ntk>
+  SatResult SatSolver2<Ntk>::CheckRedundantFanins(int id, std::vector<int> &vIdxs) {
+    time_point timeStart = GetCurrentTime();
+    RetireBlocking();
+    fPending = false;
+    fCached = false;
+    SetTarget(id);
+    nCoreCalls++;
+    if(!status) {
+      if(nVerbose) {
+        std::cout << "trivially UNSATISFIABLE" << std::endl;
+      }
+      vIdxs.clear();
+      durationRedundancy += Duration(timeStart, GetCurrentTime());
+      return UNSAT;
+    }
+    // node is 0 while kept fanins are 1, where fanin literals serve as selectors
+    vLits.clear();
+    if(iActivation != -1) {
+      vLits.push_back(toLit(iActivation));
+    }
+    assert(pNtk->GetNodeType(id) == AND);
+    vLits.push_back(toLitCond(vVars[id], 1));
+    for(int idx: vIdxs) {
+      int fi = pNtk->GetFanin(id, idx);
+      vLits.push_back(toLitCond(vVars[fi], pNtk->GetCompl(id, idx)));
+    }
+    if(nVerbose) {
+      std::cout << "solving with assumptions: ";
+      std::string delim = "";
+      for(int iLit: vLits) {
+        std::cout << delim << (lit_sign(iLit)? "!": "") << lit_var(iLit);
+        delim = ", ";
+      }
+      std::cout << std::endl;
+    }
+    nCalls++;
+    SatResult res = Solve();
+    if(res == UNSAT) {
+      // keep only fanins in final conflict
+      std::vector<int> vCore;
+      pSat->GetCore(vCore);
+      std::vector<int> vIdxsNew;
+      for(int i = 0; i < int_size(vIdxs); i++) {
+        if(std::find(vCore.begin(), vCore.end(), vLits[int_size(vLits) - int_size(vIdxs) + i]) != vCore.end()) {
+          vIdxsNew.push_back(vIdxs[i]);
+        }
+      }
+      if(nVerbose) {
+        std::cout << "UNSATISFIABLE with " << int_size(vIdxsNew) << " fanins in core" << std::endl;
+      }
+      vIdxs.swap(vIdxsNew);
+      nUnsats++;
+      durationRedundancy += Duration(timeStart, GetCurrentTime());
+      return UNSAT;
+    }
+    if(res == UNDET) {
+      if(nVerbose) {
+        std::cout << "UNDETERMINED" << std::endl;
+      }
+      durationRedundancy += Duration(timeStart, GetCurrentTime());
+      return UNDET;
+    }
+    assert(res == SAT);
     if(nVerbose) {
       std::cout << "SATISFIABLE" << std::endl;
     }
     nSats++;
+    ReadValues();
+    // required values
+    vAssumptions = vLits;
+    vRequired.clear();
+    nHarvested = 0;
+    assert(vValues[id] == TEMP_FALSE);
+    vRequired.push_back(id);
+    for(int idx: vIdxs) {
+      vRequired.push_back(pNtk->GetFanin(id, idx));
+    }
+    DecideRequired();
+    // fanins that are controlling in solution need to be kept
+    int nKeeps = int_size(vIdxs);
+    pNtk->ForEachFaninIdx(id, [&](int idx, int fi, bool c) {
+      if(!((vValues[fi] == TEMP_TRUE || vValues[fi] == rrrTRUE) ^ c)) {
+        assert(std::find(vIdxs.begin(), vIdxs.end(), idx) == vIdxs.end());
+        vIdxs.push_back(idx);
+      }
+    });
+    assert(int_size(vIdxs) > nKeeps);
+    std::sort(vIdxs.begin(), vIdxs.end());
+    durationRedundancy += Duration(timeStart, GetCurrentTime());
+    return SAT;
+  }
+  
+  /* }}} */
+
+  /* {{{ Values */
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::ReadValues() {
+    // nodes outside encoded cone are evaluated from PIs, which are unconstrained there
     vValues.clear();
     vValues.resize(pNtk->GetNumNodes());
     pNtk->ForEachPi([&](int id) {
-      if(sat_solver_var_value(pSat, vVars[id])) {
+      if(vVars[id] != -1 && pSat->GetValue(vVars[id])) {
         vValues[id] = TEMP_TRUE;
       } else {
         vValues[id] = TEMP_FALSE;
@@ -431,31 +957,48 @@ namespace rrr {
     });
     vValues2 = vValues;
     pNtk->ForEachInt([&](int id) {
-      if(sat_solver_var_value(pSat, vVars[id])) {
+      if(vVars[id] == -1) {
+        bool r = true, r2 = true;
+        pNtk->ForEachFanin(id, [&](int fi, bool c) {
+          r = r && ((vValues[fi] == TEMP_TRUE) ^ c);
+          r2 = r2 && ((vValues2[fi] == TEMP_TRUE) ^ c ^ (fi == target));
+        });
+        vValues[id] = r? TEMP_TRUE: TEMP_FALSE;
+        vValues2[id] = r2? TEMP_TRUE: TEMP_FALSE;
+        return;
+      }
+      if(pSat->GetValue(vVars[id])) {
         vValues[id] = TEMP_TRUE;
       } else {
         vValues[id] = TEMP_FALSE;
       }
-      if(sat_solver_var_value(pSat, vVars2[id])) {
+      if(pSat->GetValue(vVars2[id])) {
         vValues2[id] = TEMP_TRUE;
       } else {
         vValues2[id] = TEMP_FALSE;
       }
     });
-    // required values
-    // TODO: maybe this should be done at POs
-    assert(vValues[id] == TEMP_TRUE);
-    assert(vValues2[id] == TEMP_TRUE);
-    vValues[id] = DecideVarValue(vValues[id]);
-    vValues2[id] = DecideVarValue(vValues2[id]);
-    assert((vValues[fi] == TEMP_TRUE) ^ !c);
-    assert((vValues2[fi] == TEMP_TRUE) ^ !c);
-    vValues[fi] = DecideVarValue(vValues[fi]);
-    vValues2[fi] = DecideVarValue(vValues2[fi]);
-    durationFeasibility += Duration(timeStart, GetCurrentTime());
-    return SAT;
   }
-  
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::DecideRequired() {
+    for(int id: vRequired) {
+      vValues[id] = DecideVarValue(vValues[id]);
+      vValues2[id] = DecideVarValue(vValues2[id]);
+    }
+  }
+
+  template <typename Ntk>
+  void SatSolver2<Ntk>::RetireBlocking() {
+    if(iBlocking == -1) {
+      return;
+    }
+    int iLit = toLitCond(iBlocking, 1);
+    bool RetValue = pSat->AddClause(&iLit, 1);
+    assert(RetValue);
+    iBlocking = -1;
+  }
+
   /* }}} */
 
   /* {{{ Cex */
@@ -512,6 +1055,9 @@ namespace rrr {
 
   template <typename Ntk>
   std::vector<VarValue> SatSolver2<Ntk>::GetCex() {
+    if(fCached) {
+      return vCex;
+    }
     if(nVerbose) {
       std::cout << "cex: ";
       pNtk->ForEachPi([&](int id) {
@@ -520,7 +1066,7 @@ namespace rrr {
       std::cout << std::endl;
     }
     // reverse simulation
-    if(vVars == vVars2) {
+    if(vOutputs.empty()) {
       pNtk->ForEachIntReverse([&](int id) {
         Justify(vValues, id);
       });
@@ -535,17 +1081,16 @@ namespace rrr {
       } else if(vValues2[target] == TEMP_FALSE) {
         vValues2[target] = TEMP_TRUE;
       }
-      // pick po
+      // pick output
       bool f = true;
-      pNtk->ForEachPoDriverStop([&](int fi) {
-        if(vVars[fi] != vVars2[fi] && vValues[fi] != vValues2[fi]) {
-          vValues[fi] = DecideVarValue(vValues[fi]);
-          vValues2[fi] = DecideVarValue(vValues2[fi]);
+      for(int fo: vOutputs) {
+        if(vValues[fo] != vValues2[fo]) {
+          vValues[fo] = DecideVarValue(vValues[fo]);
+          vValues2[fo] = DecideVarValue(vValues2[fo]);
           f = false;
-          return true;
+          break;
         }
-        return false;
-      });
+      }
       assert(!f);
       // observability
       std::vector<bool> vVisited(pNtk->GetNumNodes());
@@ -608,15 +1153,67 @@ namespace rrr {
       }
       });
     // retrieve partial cex
-    std::vector<VarValue> vPartialCex;
+    vCex.clear();
     pNtk->ForEachPi([&](int id) {
       if(vValues[id] == rrrTRUE || vValues[id] == rrrFALSE) {
-        vPartialCex.push_back(vValues[id]);
+        vCex.push_back(vValues[id]);
       } else {
-        vPartialCex.push_back(UNDEF);
+        vCex.push_back(UNDEF);
       }
     });
-    return vPartialCex;
+    StoreCache(SAT);
+    return vCex;
+  }
+
+  template <typename Ntk>
+  bool SatSolver2<Ntk>::HarvestCex() {
+    if(fCached) {
+      // solver does not hold solution
+      return false;
+    }
+    if(nHarvested >= nCexes || vCex.empty()) {
+      RetireBlocking();
+      return false;
+    }
+    // block care inputs of last cex
+    vLits.clear();
+    for(int idx = 0; idx < int_size(vCex); idx++) {
+      if(vCex[idx] == UNDEF) {
+        continue;
+      }
+      int id = pNtk->GetPi(idx);
+      assert(vVars[id] != -1);
+      vLits.push_back(toLitCond(vVars[id], vCex[idx] == rrrTRUE));
+    }
+    vCex.clear();
+    if(vLits.empty()) {
+      // last cex is independent of inputs
+      RetireBlocking();
+      return false;
+    }
+    if(iBlocking == -1) {
+      iBlocking = pSat->AddVar();
+    }
+    vLits.push_back(toLitCond(iBlocking, 1));
+    bool RetValue = pSat->AddClause(vLits.data(), int_size(vLits));
+    assert(RetValue);
+    // solve again under same assumptions
+    vLits = vAssumptions;
+    vLits.push_back(toLit(iBlocking));
+    nHarvests++;
+    SatResult res = Solve();
+    if(res != SAT) {
+      RetireBlocking();
+      return false;
+    }
+    if(nVerbose) {
+      std::cout << "harvested another cex" << std::endl;
+    }
+    ReadValues();
+    DecideRequired();
+    nHarvested++;
+    nHarvestedCexes++;
+    return true;
   }
 
   /* }}} */
@@ -628,6 +1225,13 @@ namespace rrr {
     nCalls = 0;
     nSats = 0;
     nUnsats = 0;
+    nRestarts = 0;
+    nHarvests = 0;
+    nHarvestedCexes = 0;
+    nCoreCalls = 0;
+    nCacheHits = 0;
+    pSat->ResetSummary();
+    budget.ResetSummary();
     durationRedundancy = 0;
     durationFeasibility = 0;
   }
@@ -638,6 +1242,17 @@ namespace rrr {
     v.emplace_back("sat call", nCalls);
     v.emplace_back("sat satisfiable", nSats);
     v.emplace_back("sat unsatisfiable", nUnsats);
+    v.emplace_back("sat restart", nRestarts);
+    v.emplace_back("sat harvest call", nHarvests);
+    v.emplace_back("sat harvested cex", nHarvestedCexes);
+    v.emplace_back("sat core call", nCoreCalls);
+    v.emplace_back("sat cache hit", nCacheHits);
+    for(auto const &entry: pSat->GetStatsSummary()) {
+      v.push_back(entry);
+    }
+    for(auto const &entry: budget.GetStatsSummary()) {
+      v.push_back(entry);
+    }
     return v;
   }
 
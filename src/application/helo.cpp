@@ -47,17 +47,29 @@ int main(int argc, char **argv) {
     ("g,no-greedy", "Discard changes that increased the cost", cxxopts::value<bool>()->default_value("false"))
     ("a,isort", "Sort fanins before each run", cxxopts::value<bool>()->default_value("false"))
     ("b,nsort", "Soft fanins before reducing each node", cxxopts::value<bool>()->default_value("true"))
+    ("sig", "Filter candidate fanins using simulation signature index", cxxopts::value<bool>()->default_value("false"))
+    ("core", "Remove redundant fanins together using UNSAT cores", cxxopts::value<bool>()->default_value("false"))
+    ("mincore", "Minimize fanins kept by UNSAT cores", cxxopts::value<bool>()->default_value("false"))
     ;
 
   options.add_options("Analyzer")
     ("A,vana", "Verbosity level of analyzer", cxxopts::value<int>()->default_value("0"))
-    ("U,ana", "Analysis method\n 0: SAT\n 1: BDD (MSPF)\n 2: BDD (CSPF)\n 3: BDD (resim)\n 4: TT (MSPF)\n 5: TT (resim)\n", cxxopts::value<int>()->default_value("0"))
+    ("U,ana", "Analysis method\n 0: SAT\n 1: BDD (MSPF)\n 2: BDD (CSPF)\n 3: BDD (resim)\n 4: TT (MSPF)\n 5: TT (resim)\n 6: automatic (TT, BDD, or SAT per partition)\n", cxxopts::value<int>()->default_value("0"))
     ("s,save", "Save data while testing temporary changes", cxxopts::value<bool>()->default_value("true"))
+    ("order", "File to read BDD variable orders from and write them back to", cxxopts::value<std::string>())
     ;    
 
   options.add_options("SAT handler")
     ("S,vsat", "Verbosity level of SAT handler", cxxopts::value<int>()->default_value("0"))
     ("C,conf", "Conflict limit (0 = no limit)", cxxopts::value<int>()->default_value("0"))
+    ("window", "Depth of TFO window in careset miter (0 = no limit)", cxxopts::value<int>()->default_value("0"))
+    ("solver", "SAT solver\n 0: bsat\n 1: glucose\n 2: satoko\n", cxxopts::value<int>()->default_value("0"))
+    ("portfolio", "Number of helper solvers racing main solver on queries exceeding conflict limit; first 2 are of other types and the rest vary polarity (0 = off)", cxxopts::value<int>()->default_value("0"))
+    ("pconf", "Conflict limit of portfolio solvers (0 = no limit)", cxxopts::value<int>()->default_value("0"))
+    ("cexes", "Number of additional counterexamples harvested per SAT result (up to 63)", cxxopts::value<int>()->default_value("0"))
+    ("percentile", "Derive conflict limit from this percentile of conflicts of resolved queries (0 = static limit)", cxxopts::value<int>()->default_value("0"))
+    ("retry", "Number of retries of undetermined queries with escalated conflict limit", cxxopts::value<int>()->default_value("0"))
+    ("cache", "Maximum number of SAT query results memoized by structural hash (0 = no cache)", cxxopts::value<int>()->default_value("0"))
     ;
   
   options.add_options("Simulator")
@@ -109,6 +121,9 @@ int main(int argc, char **argv) {
   Par.fGreedy = !result["no-greedy"].as<bool>();
   Par.fSortInitial = result["isort"].as<bool>();
   Par.fSortPerNode = result["nsort"].as<bool>();
+  Par.fUseSignature = result["sig"].as<bool>();
+  Par.fUseCore = result["core"].as<bool>();
+  Par.fMinimizeCore = result["mincore"].as<bool>();
   
   Par.nAnalyzerVerbose = result["vana"].as<int>();
   Par.fUseBddMspf = result["ana"].as<int>() == 1;
@@ -116,10 +131,27 @@ int main(int argc, char **argv) {
   Par.fUseBddResim = result["ana"].as<int>() == 3;
   Par.fUseTt = result["ana"].as<int>() == 4;
   Par.fUseTtResim = result["ana"].as<int>() == 5;
+  Par.fUseAuto = result["ana"].as<int>() == 6;
   Par.fSave = result["save"].as<bool>();
+  if(result.count("order")) {
+    Par.strBddOrder = result["order"].as<std::string>();
+    Par.strDesign = input_filename.substr(input_filename.find_last_of('/') + 1);
+  }
 
   Par.nSatSolverVerbose = result["vsat"].as<int>();
   Par.nConflictLimit = result["conf"].as<int>();
+  Par.nSatWindowDepth = result["window"].as<int>();
+  Par.nSatBackend = result["solver"].as<int>();
+  if(Par.nSatBackend < 0 || Par.nSatBackend > 2) {
+    std::cerr << "invalid SAT solver " << Par.nSatBackend << std::endl;
+    return 1;
+  }
+  Par.nSatPortfolio = result["portfolio"].as<int>();
+  Par.nSatPortfolioConflictLimit = result["pconf"].as<int>();
+  Par.nSatCexes = result["cexes"].as<int>();
+  Par.nConflictPercentile = result["percentile"].as<int>();
+  Par.nConflictRetries = result["retry"].as<int>();
+  Par.nSatCacheSize = result["cache"].as<int>();
   
   Par.nSimulatorVerbose = result["vsim"].as<int>();
   Par.nWords = result["word"].as<int>();
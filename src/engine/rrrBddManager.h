@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cassert>
 #include <cstdlib>
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <iostream>
@@ -10,10 +12,18 @@
 namespace rrr {
 namespace NewBdd {
 
+#ifdef USE_BDD_32BIT
+  typedef unsigned           var;
+#else
   typedef unsigned short     var;
+#endif
   typedef int                bvar;
   typedef unsigned           lit;
+#ifdef USE_BDD_32BIT
+  typedef unsigned           ref;
+#else
   typedef unsigned short     ref;
+#endif
   typedef unsigned long long size;
   typedef unsigned           edge;
   typedef unsigned           uniq;
@@ -31,8 +41,36 @@ namespace NewBdd {
     std::abort();
   }
 
+  // memory far beyond size in use is released rather than kept for growing again
+  template <typename T>
+  static inline void ShrinkIfSparse(std::vector<T> &v) {
+    if(v.capacity() >> 2 > v.size())
+      v.shrink_to_fit();
+  }
+
+  // operations sharing the computed table
+  enum CacheOp {
+    CACHE_AND,
+    CACHE_OP_NUM
+  };
+
   class Cache {
   private:
+    struct Entry {
+      lit      x;
+      lit      y;
+      lit      z;
+      unsigned Tag; // generation and operation
+    };
+    static constexpr int nWaysLog = 1;
+    static constexpr int nWays = 1 << nWaysLog;
+    static constexpr int nOpBits = 4;
+    static_assert(CACHE_OP_NUM <= (1 << nOpBits), "too many cache operations");
+    // ways are ordered from most recently used, and a set fits in a cache line
+    struct alignas(32) Set {
+      Entry Ways[nWays];
+    };
+
     cac    nSize;
     cac    nMax;
     cac    Mask;
@@ -41,30 +79,48 @@ namespace NewBdd {
     size   nThold;
     double HitRate;
     int    nVerbose;
-    std::vector<lit> vCache;
+    unsigned Gen; // entries of older generations are stale
+    std::vector<Set> vSets;
+
+    static inline cac Hash(CacheOp op, lit x, lit y)   { return CacHash(x, y) + 786433 * (cac)op; }
+    inline unsigned   Tag(CacheOp op)            const { return (Gen << nOpBits) | (unsigned)op;   }
+    inline bool       IsLive(Entry const &e)     const { return (e.Tag >> nOpBits) == Gen;         }
+    inline CacheOp    OpOfEntry(Entry const &e)  const { return (CacheOp)(e.Tag & ((1 << nOpBits) - 1)); }
 
   public:
-    Cache(int nCacheSizeLog, int nCacheMaxLog, int nVerbose): nVerbose(nVerbose) {
+    Cache(int nCacheSizeLog, int nCacheMaxLog, int nVerbose): nVerbose(nVerbose), Gen(0) {
+      Reset(nCacheSizeLog, nCacheMaxLog);
+    }
+    ~Cache() {
+      if(nVerbose)
+        std::cout << "Free " << nSize << " cache entries" << std::endl;
+    }
+    void Reset(int nCacheSizeLog, int nCacheMaxLog) {
+      // memory of sets beyond initial size is kept for growing again
       if(nCacheMaxLog < nCacheSizeLog)
         fatal_error("nCacheMax must not be smaller than nCacheSize");
+      nCacheSizeLog = std::max(nCacheSizeLog, nWaysLog);
+      nCacheMaxLog = std::max(nCacheMaxLog, nWaysLog);
       nMax = (cac)1 << nCacheMaxLog;
       if(!(nMax << 1))
         fatal_error("Memout (nCacheMax) in init");
       nSize = (cac)1 << nCacheSizeLog;
       if(nVerbose)
         std::cout << "Allocating " << nSize << " cache entries" << std::endl;
-      vCache.resize(nSize * 3);
-      Mask = nSize - 1;
+      vSets.resize(nSize >> nWaysLog);
+      ShrinkIfSparse(vSets);
+      Mask = (nSize >> nWaysLog) - 1;
+      Clear();
       nLookups = 0;
       nHits = 0;
       nThold = (nSize == nMax)? SizeMax(): nSize;
       HitRate = 1;
     }
-    ~Cache() {
-      if(nVerbose)
-        std::cout << "Free " << nSize << " cache entries" << std::endl;
+    void Copy(Cache const &from) {
+      *this = from;
+      ShrinkIfSparse(vSets);
     }
-    inline lit Lookup(lit x, lit y) {
+    inline lit Lookup(CacheOp op, lit x, lit y) {
       nLookups++;
       if(nLookups > nThold) {
         double NewHitRate = (double)nHits / nLookups;
@@ -84,58 +140,98 @@ namespace NewBdd {
         }
         HitRate = NewHitRate;
       }
-      cac i = (CacHash(x, y) & Mask) * 3;
-      if(vCache[i] == x && vCache[i + 1] == y) {
+      unsigned tag = Tag(op);
+      Entry *p = vSets[Hash(op, x, y) & Mask].Ways;
+      for(int k = 0; k < nWays; k++) {
+        if(p[k].x != x || p[k].y != y || p[k].Tag != tag)
+          continue;
+        if(k) {
+          Entry e = p[k];
+          for(; k; k--)
+            p[k] = p[k - 1];
+          p[0] = e;
+        }
         if(nVerbose >= 3)
           std::cout << "Cache hit: "
+                    << "op = " << op << ", "
                     << "x = " << std::setw(10) << x << ", "
                     << "y = " << std::setw(10) << y << ", "
-                    << "z = " << std::setw(10) << vCache[i + 2] << ", "
-                    << "hash = " << std::hex << (CacHash(x, y) & Mask) << std::dec
+                    << "z = " << std::setw(10) << p->z << ", "
+                    << "hash = " << std::hex << (Hash(op, x, y) & Mask) << std::dec
                     << std::endl;
         nHits++;
-        return vCache[i + 2];
+        return p->z;
       }
       return LitMax();
     }
-    inline void Insert(lit x, lit y, lit z) {
-      cac i = (CacHash(x, y) & Mask) * 3;
-      vCache[i] = x;
-      vCache[i + 1] = y;
-      vCache[i + 2] = z;
+    inline void Insert(CacheOp op, lit x, lit y, lit z) {
+      Entry *p = vSets[Hash(op, x, y) & Mask].Ways;
+      // take first stale way, or least recently used one
+      int k = 0;
+      while(k < nWays - 1 && IsLive(p[k]))
+        k++;
+      for(; k; k--)
+        p[k] = p[k - 1];
+      p->x = x;
+      p->y = y;
+      p->z = z;
+      p->Tag = Tag(op);
       if(nVerbose >= 3)
         std::cout << "Cache ent: "
+                  << "op = " << op << ", "
                   << "x = " << std::setw(10) << x << ", "
                   << "y = " << std::setw(10) << y << ", "
                   << "z = " << std::setw(10) << z << ", "
-                  << "hash = " << std::hex << (CacHash(x, y) & Mask) << std::dec
+                  << "hash = " << std::hex << (Hash(op, x, y) & Mask) << std::dec
                   << std::endl;
     }
     inline void Clear() {
-      std::fill(vCache.begin(), vCache.end(), 0);
+      Gen++;
+      if(Gen >> (32 - nOpBits)) {
+        // generation wrapped around
+        for(cac i = 0; i <= Mask; i++)
+          for(int k = 0; k < nWays; k++)
+            vSets[i].Ways[k].Tag = 0;
+        Gen = 1;
+      }
+    }
+    inline void ClearFrom(lit x) {
+      // entries with any literal of x or above become stale
+      for(cac i = 0; i <= Mask; i++)
+        for(int k = 0; k < nWays; k++)
+          if(vSets[i].Ways[k].x >= x || vSets[i].Ways[k].y >= x || vSets[i].Ways[k].z >= x)
+            vSets[i].Ways[k].Tag = 0;
     }
     void Resize() {
-      cac nSizeOld = nSize;
+      cac nSetsOld = nSize >> nWaysLog;
       nSize <<= 1;
       if(nVerbose >= 2)
         std::cout << "Reallocating " << nSize << " cache entries" << std::endl;
-      vCache.resize(nSize * 3);
-      Mask = nSize - 1;
-      for(cac j = 0; j < nSizeOld; j++) {
-        cac i = j * 3;
-        if(vCache[i] || vCache[i + 1]) {
-          cac hash = (CacHash(vCache[i], vCache[i + 1]) & Mask) * 3;
-          vCache[hash] = vCache[i];
-          vCache[hash + 1] = vCache[i + 1];
-          vCache[hash + 2] = vCache[i + 2];
+      vSets.resize(nSize >> nWaysLog);
+      Mask = (nSize >> nWaysLog) - 1;
+      // live entries either stay or move to the set in upper half, keeping their order
+      for(cac j = 0; j < nSetsOld; j++) {
+        Entry *p = vSets[j].Ways;
+        Entry *q = vSets[j + nSetsOld].Ways;
+        int iStay = 0, iMove = 0;
+        for(int k = 0; k < nWays; k++) {
+          if(!IsLive(p[k]))
+            continue;
+          cac hash = Hash(OpOfEntry(p[k]), p[k].x, p[k].y) & Mask;
           if(nVerbose >= 3)
             std::cout << "Cache mov: "
-                      << "x = " << std::setw(10) << vCache[i] << ", "
-                      << "y = " << std::setw(10) << vCache[i + 1] << ", "
-                      << "z = " << std::setw(10) << vCache[i + 2] << ", "
-                      << "hash = " << std::hex << (CacHash(vCache[i], vCache[i + 1]) & Mask) << std::dec
+                      << "x = " << std::setw(10) << p[k].x << ", "
+                      << "y = " << std::setw(10) << p[k].y << ", "
+                      << "z = " << std::setw(10) << p[k].z << ", "
+                      << "hash = " << std::hex << hash << std::dec
                       << std::endl;
+          if(hash == j)
+            p[iStay++] = p[k];
+          else
+            q[iMove++] = p[k];
         }
+        for(; iStay < nWays; iStay++)
+          p[iStay].Tag = 0;
       }
     }
   };
@@ -174,6 +270,32 @@ namespace NewBdd {
   };
 
   class Man {
+  public:
+    // node high-water mark, valid while nodes are neither collected, recycled, nor reordered ({0, 0} is never valid)
+    struct Snapshot {
+      bvar     nObjs;
+      unsigned Epoch;
+    };
+
+  private:
+    // fields accessed together by unique table lookup are kept in one record
+    struct Node {
+      lit  Then;
+      lit  Else;
+      bvar Next;
+      var  Var;
+      ref  Ref;
+    };
+    struct AndFrame {
+      lit  x;
+      lit  y;
+      lit  x0;
+      lit  y0;
+      lit  z1;
+      var  v;
+      bool fElse;
+    };
+
   private:
     var    nVars;
     bvar   nObjs;
@@ -181,34 +303,36 @@ namespace NewBdd {
     bvar   nObjsMax;
     unsigned long long nCreatedTotal;
     bvar   RemovedHead;
+    unsigned Epoch; // changes whenever existing node indices may be removed or reused
     int    nGbc;
     bvar   nReo;
     double MaxGrowth;
     bool   fReoVerbose;
     int    nVerbose;
-    std::vector<var>    vVars;
+    int   *pStop;
+    bool   fMemout;
+    bool   fRefs;
+    std::vector<Node>   vNodes;
     std::vector<var>    Var2Level;
     std::vector<var>    Level2Var;
-    std::vector<lit>    vObjs;
-    std::vector<bvar>   vNexts;
     std::vector<bool>   vMarks;
-    std::vector<ref>    vRefs;
     std::vector<edge>   vEdges;
     std::vector<double> vOneCounts;
     std::vector<uniq>   vUniqueMasks;
     std::vector<bvar>   vUniqueCounts;
     std::vector<bvar>   vUniqueTholds;
     std::vector<std::vector<bvar> > vvUnique;
+    std::vector<AndFrame> vAndStack;
     Cache *cache;
 
   public:
     inline lit  Bvar2Lit(bvar a)          const { return (lit)a << 1;                                       }
     inline lit  Bvar2Lit(bvar a, bool c)  const { return ((lit)a << 1) ^ (lit)c;                            }
     inline bvar Lit2Bvar(lit x)           const { return (bvar)(x >> 1);                                    }
-    inline var  VarOfBvar(bvar a)         const { return vVars[a];                                          }
-    inline lit  ThenOfBvar(bvar a)        const { return vObjs[Bvar2Lit(a)];                                }
-    inline lit  ElseOfBvar(bvar a)        const { return vObjs[Bvar2Lit(a, true)];                          }
-    inline ref  RefOfBvar(bvar a)         const { return vRefs[a];                                          }
+    inline var  VarOfBvar(bvar a)         const { return vNodes[a].Var;                                     }
+    inline lit  ThenOfBvar(bvar a)        const { return vNodes[a].Then;                                    }
+    inline lit  ElseOfBvar(bvar a)        const { return vNodes[a].Else;                                    }
+    inline ref  RefOfBvar(bvar a)         const { return vNodes[a].Ref;                                     }
     inline lit  Const0()                  const { return (lit)0;                                            }
     inline lit  Const1()                  const { return (lit)1;                                            }
     inline bool IsConst0(lit x)           const { return x == Const0();                                     }
@@ -220,11 +344,12 @@ namespace NewBdd {
     inline lit  LitNotCond(lit x, bool c) const { return x ^ (lit)c;                                        }
     inline bool LitIsCompl(lit x)         const { return x & (lit)1;                                        }
     inline bool LitIsEq(lit x, lit y)     const { return x == y;                                            }
-    inline var  Var(lit x)                const { return vVars[Lit2Bvar(x)];                                }
+    inline bool LitIsInvalid(lit x)       const { return Lit2Bvar(x) == BvarMax();                          }
+    inline var  Var(lit x)                const { return vNodes[Lit2Bvar(x)].Var;                           }
     inline var  Level(lit x)              const { return Var2Level[Var(x)];                                 }
-    inline lit  Then(lit x)               const { return LitNotCond(vObjs[LitRegular(x)], LitIsCompl(x));   }
-    inline lit  Else(lit x)               const { return LitNotCond(vObjs[LitIrregular(x)], LitIsCompl(x)); }
-    inline ref  Ref(lit x)                const { return vRefs[Lit2Bvar(x)];                                }
+    inline lit  Then(lit x)               const { return LitNotCond(ThenOfBvar(Lit2Bvar(x)), LitIsCompl(x)); }
+    inline lit  Else(lit x)               const { return LitNotCond(ElseOfBvar(Lit2Bvar(x)), LitIsCompl(x)); }
+    inline ref  Ref(lit x)                const { return vNodes[Lit2Bvar(x)].Ref;                           }
     inline double OneCount(lit x)         const {
       if(vOneCounts.empty())
         fatal_error("fCountOnes was not set");
@@ -234,8 +359,8 @@ namespace NewBdd {
     }
 
   public:
-    inline void IncRef(lit x)              { if(!vRefs.empty() && Ref(x) != RefMax()) vRefs[Lit2Bvar(x)]++; }
-    inline void DecRef(lit x)              { if(!vRefs.empty() && Ref(x) != RefMax()) vRefs[Lit2Bvar(x)]--; }
+    inline void IncRef(lit x)              { if(fRefs && !LitIsInvalid(x) && Ref(x) != RefMax()) vNodes[Lit2Bvar(x)].Ref++; }
+    inline void DecRef(lit x)              { if(fRefs && !LitIsInvalid(x) && Ref(x) != RefMax()) vNodes[Lit2Bvar(x)].Ref--; }
 
   private:
     inline bool Mark(lit x)               const { return vMarks[Lit2Bvar(x)];                               }
@@ -246,24 +371,30 @@ namespace NewBdd {
     inline void DecEdge(lit x)                  { vEdges[Lit2Bvar(x)]--;                                    }
     inline bool MarkOfBvar(bvar a)        const { return vMarks[a];                                         }
     inline edge EdgeOfBvar(bvar a)        const { return vEdges[a];                                         }
-    inline void SetVarOfBvar(bvar a, var v)     { vVars[a] = v;                                             }
-    inline void SetThenOfBvar(bvar a, lit x)    { vObjs[Bvar2Lit(a)] = x;                                   }
-    inline void SetElseOfBvar(bvar a, lit x)    { vObjs[Bvar2Lit(a, true)] = x;                             }
+    inline bvar *NextOfBvar(bvar a)             { return &vNodes[a].Next;                                   }
+    inline void SetVarOfBvar(bvar a, var v)     { vNodes[a].Var = v;                                        }
+    inline void SetThenOfBvar(bvar a, lit x)    { vNodes[a].Then = x;                                       }
+    inline void SetElseOfBvar(bvar a, lit x)    { vNodes[a].Else = x;                                       }
     inline void SetMarkOfBvar(bvar a)           { vMarks[a] = true;                                         }
     inline void ResetMarkOfBvar(bvar a)         { vMarks[a] = false;                                        }
     inline void RemoveBvar(bvar a)              {
       var v = VarOfBvar(a);
       SetVarOfBvar(a, VarMax());
-      std::vector<bvar>::iterator q = vvUnique[v].begin() + (UniqHash(ThenOfBvar(a), ElseOfBvar(a)) & vUniqueMasks[v]);
-      for(; *q; q = vNexts.begin() + *q)
+      bvar *q = &vvUnique[v][UniqHash(ThenOfBvar(a), ElseOfBvar(a)) & vUniqueMasks[v]];
+      for(; *q; q = NextOfBvar(*q))
         if(*q == a)
           break;
-      bvar next = vNexts[*q];
-      vNexts[*q] = RemovedHead;
+      bvar next = *NextOfBvar(*q);
+      *NextOfBvar(*q) = RemovedHead;
       RemovedHead = *q;
       *q = next;
       vUniqueCounts[v]--;
     }
+    inline void ClearRefs()                     {
+      for(bvar a = 0; a < nObjsAlloc; a++)
+        vNodes[a].Ref = 0;
+      fRefs = true;
+    }
 
   private:
     void SetMark_rec(lit x) {
@@ -319,12 +450,8 @@ namespace NewBdd {
         nObjsAlloc = (bvar)nObjsAllocLit;
       if(nVerbose >= 2)
         std::cout << "Reallocating " << nObjsAlloc << " nodes" << std::endl;
-      vVars.resize(nObjsAlloc);
-      vObjs.resize((lit)nObjsAlloc * 2);
-      vNexts.resize(nObjsAlloc);
+      vNodes.resize(nObjsAlloc);
       vMarks.resize(nObjsAlloc);
-      if(!vRefs.empty())
-        vRefs.resize(nObjsAlloc);
       if(!vEdges.empty())
         vEdges.resize(nObjsAlloc);
       if(!vOneCounts.empty())
@@ -344,8 +471,8 @@ namespace NewBdd {
       vvUnique[v].resize(nUniqueSize);
       vUniqueMasks[v] = nUniqueSize - 1;
       for(uniq i = 0; i < nUniqueSizeOld; i++) {
-        std::vector<bvar>::iterator q, tail, tail1, tail2;
-        q = tail1 = vvUnique[v].begin() + i;
+        bvar *q, *tail, *tail1, *tail2;
+        q = tail1 = &vvUnique[v][i];
         tail2 = q + nUniqueSizeOld;
         while(*q) {
           uniq hash = UniqHash(ThenOfBvar(*q), ElseOfBvar(*q)) & vUniqueMasks[v];
@@ -355,7 +482,7 @@ namespace NewBdd {
             tail = tail2;
           if(tail != q)
             *tail = *q, *q = 0;
-          q = vNexts.begin() + *tail;
+          q = NextOfBvar(*tail);
           if(tail == tail1)
             tail1 = q;
           else
@@ -369,6 +496,7 @@ namespace NewBdd {
     bool Gbc() {
       if(nVerbose >= 2)
         std::cout << "Garbage collect" << std::endl;
+      Epoch++;
       if(!vEdges.empty()) {
         for(bvar a = (bvar)nVars + 1; a < nObjs; a++)
           if(!EdgeOfBvar(a) && VarOfBvar(a) != VarMax())
@@ -389,10 +517,13 @@ namespace NewBdd {
     }
 
   private:
+    inline bool IsInterrupted() const {
+      return fMemout || (pStop && *pStop);
+    }
     inline lit UniqueCreateInt(var v, lit x1, lit x0) {
-      std::vector<bvar>::iterator p, q;
-      p = q = vvUnique[v].begin() + (UniqHash(x1, x0) & vUniqueMasks[v]);
-      for(; *q; q = vNexts.begin() + *q)
+      bvar *p, *q;
+      p = q = &vvUnique[v][UniqHash(x1, x0) & vUniqueMasks[v]];
+      for(; *q; q = NextOfBvar(*q))
         if(VarOfBvar(*q) == v && ThenOfBvar(*q) == x1 && ElseOfBvar(*q) == x0)
           return Bvar2Lit(*q);
       nCreatedTotal++;
@@ -400,13 +531,13 @@ namespace NewBdd {
       if(nObjs < nObjsAlloc)
         *p = nObjs++;
       else if(RemovedHead)
-        *p = RemovedHead, RemovedHead = vNexts[*p];
+        *p = RemovedHead, RemovedHead = *NextOfBvar(*p), Epoch++;
       else
         return LitMax();
       SetVarOfBvar(*p, v);
       SetThenOfBvar(*p, x1);
       SetElseOfBvar(*p, x0);
-      vNexts[*p] = next;
+      *NextOfBvar(*p) = next;
       if(!vOneCounts.empty())
         vOneCounts[*p] = OneCount(x1) / 2 + OneCount(x0) / 2;
       if(nVerbose >= 3) {
@@ -439,42 +570,79 @@ namespace NewBdd {
           bool fRemoved = false;
           if(nGbc > 1)
             fRemoved = Gbc();
-          if(!Resize() && !fRemoved && (nGbc != 1 || !Gbc()))
-            fatal_error("Memout (node)");
+          if(!Resize() && !fRemoved && (nGbc != 1 || !Gbc())) {
+            // operations are given up from here on, leaving manager usable for existing nodes
+            fMemout = true;
+            return LitMax();
+          }
         } else
           break;
       }
       return LitIsCompl(x0)? LitNot(x): x;
     }
-    lit And_rec(lit x, lit y) {
-      if(x == 0 || y == 1)
-        return x;
-      if(x == 1 || y == 0)
-        return y;
-      if(Lit2Bvar(x) == Lit2Bvar(y))
-        return (x == y)? x: 0;
-      if(x > y)
-        std::swap(x, y);
-      lit z = cache->Lookup(x, y);
-      if(z != LitMax())
-        return z;
-      var v;
-      lit x0, x1, y0, y1;
-      if(Level(x) < Level(y))
-        v = Var(x), x1 = Then(x), x0 = Else(x), y0 = y1 = y;
-      else if(Level(x) > Level(y))
-        v = Var(y), x0 = x1 = x, y1 = Then(y), y0 = Else(y);
-      else
-        v = Var(x), x1 = Then(x), x0 = Else(x), y1 = Then(y), y0 = Else(y);
-      lit z1 = And_rec(x1, y1);
-      IncRef(z1);
-      lit z0 = And_rec(x0, y0);
-      IncRef(z0);
-      z = UniqueCreate(v, z1, z0);
-      DecRef(z1);
-      DecRef(z0);
-      cache->Insert(x, y, z);
-      return z;
+    lit And_iter(lit x, lit y) {
+      // apply with explicit stack, visiting cofactors in the same order as recursion would
+      vAndStack.clear();
+      lit z;
+      while(true) {
+        // descend until the call is resolved
+        if(x == 0 || y == 1)
+          z = x;
+        else if(x == 1 || y == 0)
+          z = y;
+        else if(Lit2Bvar(x) == Lit2Bvar(y))
+          z = (x == y)? x: 0;
+        else {
+          if(x > y)
+            std::swap(x, y);
+          z = cache->Lookup(CACHE_AND, x, y);
+          if(z == LitMax() && !IsInterrupted()) {
+            AndFrame f;
+            f.x = x;
+            f.y = y;
+            f.fElse = false;
+            lit x1, y1;
+            if(Level(x) < Level(y))
+              f.v = Var(x), x1 = Then(x), f.x0 = Else(x), f.y0 = y1 = y;
+            else if(Level(x) > Level(y))
+              f.v = Var(y), f.x0 = x1 = x, y1 = Then(y), f.y0 = Else(y);
+            else
+              f.v = Var(x), x1 = Then(x), f.x0 = Else(x), y1 = Then(y), f.y0 = Else(y);
+            vAndStack.push_back(f);
+            x = x1;
+            y = y1;
+            continue;
+          }
+        }
+        // return to callers
+        while(true) {
+          if(vAndStack.empty())
+            return z;
+          AndFrame &f = vAndStack.back();
+          if(z == LitMax()) {
+            if(f.fElse)
+              DecRef(f.z1);
+            vAndStack.pop_back();
+            continue;
+          }
+          if(!f.fElse) {
+            f.z1 = z;
+            IncRef(f.z1);
+            f.fElse = true;
+            x = f.x0;
+            y = f.y0;
+            break;
+          }
+          IncRef(z);
+          lit r = UniqueCreate(f.v, f.z1, z);
+          DecRef(f.z1);
+          DecRef(z);
+          if(!LitIsInvalid(r))
+            cache->Insert(CACHE_AND, f.x, f.y, r);
+          z = r;
+          vAndStack.pop_back();
+        }
+      }
     }
 
   private:
@@ -483,13 +651,16 @@ namespace NewBdd {
       var v2 = Level2Var[i + 1];
       bvar f = 0;
       bvar diff = 0;
-      for(std::vector<bvar>::iterator p = vvUnique[v1].begin(); p != vvUnique[v1].end(); p++) {
-        std::vector<bvar>::iterator q = p;
+      // swap cannot be undone halfway, so it is skipped unless every node of v1 can be rebuilt twice
+      if((lit)nObjsMax - (lit)nObjs < 2 * (lit)vUniqueCounts[v1])
+        return 0;
+      for(uniq i = 0; i < vvUnique[v1].size(); i++) {
+        bvar *q = &vvUnique[v1][i];
         while(*q) {
           if(!EdgeOfBvar(*q)) {
             SetVarOfBvar(*q, VarMax());
-            bvar next = vNexts[*q];
-            vNexts[*q] = RemovedHead;
+            bvar next = *NextOfBvar(*q);
+            *NextOfBvar(*q) = RemovedHead;
             RemovedHead = *q;
             *q = next;
             vUniqueCounts[v1]--;
@@ -504,14 +675,14 @@ namespace NewBdd {
             DecEdge(f0);
             if(Var(f0) == v2 && !Edge(f0))
               DecEdge(Then(f0)), DecEdge(Else(f0)), diff--;
-            bvar next = vNexts[*q];
-            vNexts[*q] = f;
+            bvar next = *NextOfBvar(*q);
+            *NextOfBvar(*q) = f;
             f = *q;
             *q = next;
             vUniqueCounts[v1]--;
             continue;
           }
-          q = vNexts.begin() + *q;
+          q = NextOfBvar(*q);
         }
       }
       while(f) {
@@ -530,6 +701,7 @@ namespace NewBdd {
           f1 = f11;
         else {
           f1 = UniqueCreate(v1, f11, f01);
+          assert(!LitIsInvalid(f1));
           if(!Edge(f1))
             IncEdge(f11), IncEdge(f01), diff++;
         }
@@ -539,6 +711,7 @@ namespace NewBdd {
           f0 = f10;
         else {
           f0 = UniqueCreate(v1, f10, f00);
+          assert(!LitIsInvalid(f0));
           if(!Edge(f0))
             IncEdge(f10), IncEdge(f00), diff++;
         }
@@ -547,9 +720,9 @@ namespace NewBdd {
         SetVarOfBvar(f, v2);
         SetThenOfBvar(f, f1);
         SetElseOfBvar(f, f0);
-        std::vector<bvar>::iterator q = vvUnique[v2].begin() + (UniqHash(f1, f0) & vUniqueMasks[v2]);
-        lit next = vNexts[f];
-        vNexts[f] = *q;
+        bvar *q = &vvUnique[v2][UniqHash(f1, f0) & vUniqueMasks[v2]];
+        bvar next = *NextOfBvar(f);
+        *NextOfBvar(f) = *q;
         *q = f;
         vUniqueCounts[v2]++;
         f = next;
@@ -574,6 +747,8 @@ namespace NewBdd {
           std::swap(sift_order[max_j], sift_order[i]);
       }
       for(var v = 0; v < nVars; v++) {
+        if(pStop && *pStop)
+          break;
         bvar lev = Var2Level[sift_order[v]];
         bool UpFirst = lev < (bvar)(nVars / 2);
         bvar min_lev = lev;
@@ -640,14 +815,17 @@ namespace NewBdd {
       }
     }
 
-  public:
-    Man(int nVars_, Param p) {
+  private:
+    void Init(int nVars_, Param const &p) {
+      // arrays left from previous use shrink to initial sizes, so that their memory is reused without page faults unless far larger
       nCreatedTotal = 0;
       nVerbose = p.nVerbose;
+      fMemout = false;
+      fRefs = false;
       // parameter sanity check
       if(p.nObjsMaxLog < p.nObjsAllocLog)
         fatal_error("nObjsMax must not be smaller than nObjsAlloc");
-      if(nVars_ >= (int)VarMax())
+      if((lit)nVars_ >= (lit)VarMax())
         fatal_error("Memout (nVars) in init");
       nVars = nVars_;
       lit nObjsMaxLit = (lit)1 << p.nObjsMaxLog;
@@ -672,32 +850,41 @@ namespace NewBdd {
       // allocation
       if(nVerbose)
         std::cout << "Allocating " << nObjsAlloc << " nodes and " << nVars << " x " << nUniqueSize << " unique table entries" << std::endl;
-      vVars.resize(nObjsAlloc);
-      vObjs.resize((lit)nObjsAlloc * 2);
-      vNexts.resize(nObjsAlloc);
-      vMarks.resize(nObjsAlloc);
+      for(bvar a = 0; a < nObjs && a < nObjsAlloc; a++)
+        vNodes[a].Ref = 0;
+      vNodes.resize(nObjsAlloc);
+      ShrinkIfSparse(vNodes);
+      vMarks.assign(nObjsAlloc, false);
+      ShrinkIfSparse(vMarks);
+      vEdges.clear();
       vvUnique.resize(nVars);
       vUniqueMasks.resize(nVars);
-      vUniqueCounts.resize(nVars);
+      vUniqueCounts.assign(nVars, 0);
       vUniqueTholds.resize(nVars);
       for(var v = 0; v < nVars; v++) {
-        vvUnique[v].resize(nUniqueSize);
+        vvUnique[v].assign(nUniqueSize, 0);
+        ShrinkIfSparse(vvUnique[v]);
         vUniqueMasks[v] = nUniqueSize - 1;
         if((lit)(nUniqueSize * p.UniqueDensity) > (lit)BvarMax())
           vUniqueTholds[v] = BvarMax();
         else
           vUniqueTholds[v] = (bvar)(nUniqueSize * p.UniqueDensity);
       }
+      vOneCounts.clear();
       if(p.fCountOnes) {
         if(nVars > 1023)
           fatal_error("nVars must be less than 1024 to count ones");
         vOneCounts.resize(nObjsAlloc);
       }
+      ShrinkIfSparse(vOneCounts);
       // set up cache
-      cache = new Cache(p.nCacheSizeLog, p.nCacheMaxLog, p.nCacheVerbose);
+      if(cache)
+        cache->Reset(p.nCacheSizeLog, p.nCacheMaxLog);
+      else
+        cache = new Cache(p.nCacheSizeLog, p.nCacheMaxLog, p.nCacheVerbose);
       // create nodes for variables
       nObjs = 1;
-      vVars[0] = VarMax();
+      vNodes[0].Var = VarMax();
       for(var v = 0; v < nVars; v++)
         UniqueCreateInt(v, 1, 0);
       // set up variable order
@@ -712,12 +899,76 @@ namespace NewBdd {
       }
       // set other parameters
       RemovedHead = 0;
+      Epoch++;
       nGbc = p.nGbc;
       nReo = p.nReo;
       MaxGrowth = p.MaxGrowth;
       fReoVerbose = p.fReoVerbose;
-      if(nGbc || nReo != BvarMax())
-        vRefs.resize(nObjsAlloc);
+      fRefs = nGbc || nReo != BvarMax();
+    }
+    void Init(Man const &from) {
+      // nodes are copied without references, so they stay only until collected
+      nCreatedTotal = 0;
+      nVerbose = from.nVerbose;
+      fMemout = from.fMemout;
+      fRefs = from.fRefs;
+      nVars = from.nVars;
+      nObjs = from.nObjs;
+      nObjsAlloc = from.nObjsAlloc;
+      nObjsMax = from.nObjsMax;
+      vNodes = from.vNodes;
+      ShrinkIfSparse(vNodes);
+      for(bvar a = 0; a < nObjsAlloc; a++)
+        vNodes[a].Ref = 0;
+      vMarks = from.vMarks;
+      ShrinkIfSparse(vMarks);
+      vEdges.clear();
+      vvUnique.resize(nVars);
+      for(var v = 0; v < nVars; v++) {
+        vvUnique[v] = from.vvUnique[v];
+        ShrinkIfSparse(vvUnique[v]);
+      }
+      vUniqueMasks = from.vUniqueMasks;
+      vUniqueCounts = from.vUniqueCounts;
+      vUniqueTholds = from.vUniqueTholds;
+      vOneCounts = from.vOneCounts;
+      ShrinkIfSparse(vOneCounts);
+      if(cache)
+        cache->Copy(*from.cache);
+      else
+        cache = new Cache(*from.cache);
+      Var2Level = from.Var2Level;
+      Level2Var = from.Level2Var;
+      RemovedHead = from.RemovedHead;
+      Epoch++;
+      nGbc = from.nGbc;
+      nReo = from.nReo;
+      MaxGrowth = from.MaxGrowth;
+      fReoVerbose = from.fReoVerbose;
+    }
+
+  public:
+    Man(int nVars_, Param p) {
+      nObjs = 0;
+      Epoch = 0;
+      pStop = NULL;
+      cache = NULL;
+      Init(nVars_, p);
+    }
+    Man(Man const &from) {
+      nObjs = 0;
+      Epoch = 0;
+      pStop = NULL;
+      cache = NULL;
+      Init(from);
+    }
+    void Reset(int nVars_, Param p) {
+      // starts over with new variables as if newly constructed
+      Init(nVars_, p);
+    }
+    void Reset(Man const &from) {
+      // starts over as if copied from another manager
+      Init(from);
     }
     ~Man() {
       if(nVerbose) {
@@ -729,16 +980,29 @@ namespace NewBdd {
           delim = ", ";
         }
         std::cout << "} unique table entries" << std::endl;
-        if(!vRefs.empty())
-          std::cout << "Free " << vRefs.size() << " refs" << std::endl;
+        if(fRefs)
+          std::cout << "Free " << nObjsAlloc << " refs" << std::endl;
       }
       delete cache;
     }
+    inline void ReorderIfGrown() {
+      if(nObjs > nReo) {
+        Reorder();
+        while(nReo < nObjs) {
+          nReo <<= 1;
+          if((lit)nReo > (lit)BvarMax())
+            nReo = BvarMax();
+        }
+      }
+    }
     void Reorder() {
+      if(fMemout)
+        return;
       if(nVerbose >= 2)
         std::cout << "Reorder" << std::endl;
       int nGbc_ = nGbc;
       nGbc = 0;
+      Epoch++;
       CountEdges();
       Sift();
       vEdges.clear();
@@ -746,15 +1010,11 @@ namespace NewBdd {
       nGbc = nGbc_;
     }
     inline lit And(lit x, lit y) {
-      if(nObjs > nReo) {
-        Reorder();
-        while(nReo < nObjs) {
-          nReo <<= 1;
-          if((lit)nReo > (lit)BvarMax())
-            nReo = BvarMax();
-        }
-      }
-      return And_rec(x, y);
+      // interrupted operations return LitMax, which propagates through later ones
+      if(LitIsInvalid(x) || LitIsInvalid(y) || IsInterrupted())
+        return LitMax();
+      ReorderIfGrown();
+      return And_iter(x, y);
     }
     inline lit Or(lit x, lit y) {
       return LitNot(And(LitNot(x), LitNot(y)));
@@ -762,14 +1022,13 @@ namespace NewBdd {
 
   public:
     void SetRef(std::vector<lit> const &vLits) {
-      vRefs.clear();
-      vRefs.resize(nObjsAlloc);
+      ClearRefs();
       for(size_t i = 0; i < vLits.size(); i++)
         IncRef(vLits[i]);
     }
     void RemoveRefIfUnused() {
       if(!nGbc && nReo == BvarMax())
-        vRefs.clear();
+        fRefs = false;
     }
     void TurnOnReo(int nReo_ = 0, std::vector<lit> const *vLits = NULL) {
       if(nReo_)
@@ -778,16 +1037,22 @@ namespace NewBdd {
         nReo = nObjs << 1;
       if((lit)nReo > (lit)BvarMax())
         nReo = BvarMax();
-      if(vRefs.empty()) {
+      if(!fRefs) {
         if(vLits)
           SetRef(*vLits);
         else
-          vRefs.resize(nObjsAlloc);
+          ClearRefs();
       }
     }
     void TurnOffReo() {
       nReo = BvarMax();
     }
+    void SetStop(int *pStop_) {
+      pStop = pStop_;
+    }
+    bool IsMemout() const {
+      return fMemout;
+    }
     var GetNumVars() const {
       return nVars;
     }
@@ -830,11 +1095,11 @@ namespace NewBdd {
       bvar nRemoved = 0;
       bvar a = RemovedHead;
       while(a)
-        a = vNexts[a], nRemoved++;
+        a = *NextOfBvar(a), nRemoved++;
       bvar nLive = 1;
       for(var v = 0; v < nVars; v++)
         nLive += vUniqueCounts[v];
-      std::cout << "ref: " << std::setw(10) << (vRefs.empty()? 0: CountNodes()) << ", "
+      std::cout << "ref: " << std::setw(10) << (fRefs? CountNodes(): 0) << ", "
                 << "used: " << std::setw(10) << nObjs << ", "
                 << "live: " << std::setw(10) << nLive << ", "
                 << "dead: " << std::setw(10) << nRemoved << ", "
@@ -844,6 +1109,32 @@ namespace NewBdd {
     unsigned long long GetNumTotalCreatedNodes() {
       return nCreatedTotal;
     }
+    bool IsCrowded() const {
+      // node space cannot grow any more and is almost used up
+      return nObjsAlloc == nObjsMax && nObjs > nObjsMax - nObjsMax / 8;
+    }
+    Snapshot TakeSnapshot() const {
+      return {nObjs, Epoch};
+    }
+    bool Restore(Snapshot const &s) {
+      // removes nodes created after snapshot, which must be unreferenced, or returns false if they cannot be told apart
+      if(s.nObjs <= (bvar)nVars || s.Epoch != Epoch || s.nObjs > nObjs)
+        return false;
+      if(s.nObjs == nObjs)
+        return true;
+      // new nodes have been pushed in order at heads of their unique lists, so they are popped from heads in reverse
+      while(nObjs > s.nObjs) {
+        bvar a = --nObjs;
+        assert(!fRefs || !RefOfBvar(a));
+        var v = VarOfBvar(a);
+        bvar *q = &vvUnique[v][UniqHash(ThenOfBvar(a), ElseOfBvar(a)) & vUniqueMasks[v]];
+        assert(*q == a);
+        *q = *NextOfBvar(a);
+        vUniqueCounts[v]--;
+      }
+      cache->ClearFrom(Bvar2Lit(s.nObjs));
+      return true;
+    }
   };
 
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+
+#ifdef ABC_USE_PTHREADS
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "misc/rrrUtils.h"
+#include "engine/rrrBddManager.h"
+
+namespace rrr {
+
+  // BDD manager built once for copies of a network, from which their managers start as copies
+  class BddBase {
+  private:
+    // data
+    std::vector<int> vKeys; // identities of inputs
+    NewBdd::Man *pBdd;
+    bool fBuilding; // one of copies is building it while others wait
+    bool fFailed;
+#ifdef ABC_USE_PTHREADS
+    std::mutex mutexBase;
+    std::condition_variable condBase;
+#endif
+
+  public:
+    // constructors
+    BddBase();
+    ~BddBase();
+
+    // manager (returns NULL if not available, where caller must publish if fBuild is set)
+    NewBdd::Man const *Acquire(std::vector<int> const &vKeys_, bool &fBuild);
+    void Publish(NewBdd::Man const *pBdd_); // NULL if failed
+  };
+
+  /* {{{ Constructors */
+
+  inline BddBase::BddBase() :
+    pBdd(NULL),
+    fBuilding(false),
+    fFailed(false) {
+  }
+
+  inline BddBase::~BddBase() {
+    delete pBdd;
+  }
+
+  /* }}} */
+
+  /* {{{ Manager */
+
+  inline NewBdd::Man const *BddBase::Acquire(std::vector<int> const &vKeys_, bool &fBuild) {
+    fBuild = false;
+#ifdef ABC_USE_PTHREADS
+    std::unique_lock<std::mutex> l(mutexBase);
+    // building takes as long as building own one, so waiting loses nothing
+    condBase.wait(l, [&] { return !fBuilding; });
+#endif
+    if(pBdd) {
+      // published manager is never modified, so it can be copied without lock
+      return vKeys == vKeys_? pBdd: NULL;
+    }
+    if(!fFailed) {
+      vKeys = vKeys_;
+      fBuilding = true;
+      fBuild = true;
+    }
+    return NULL;
+  }
+
+  inline void BddBase::Publish(NewBdd::Man const *pBdd_) {
+#ifdef ABC_USE_PTHREADS
+    std::unique_lock<std::mutex> l(mutexBase);
+#endif
+    assert(fBuilding);
+    if(pBdd_) {
+      pBdd = new NewBdd::Man(*pBdd_);
+    } else {
+      fFailed = true;
+    }
+    fBuilding = false;
+#ifdef ABC_USE_PTHREADS
+    condBase.notify_all();
+#endif
+  }
+
+  /* }}} */
+
+}
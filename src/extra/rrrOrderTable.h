@@ -0,0 +1,191 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+#ifdef ABC_USE_PTHREADS
+#include <mutex>
+#endif
+
+#include "misc/rrrUtils.h"
+
+namespace rrr {
+
+  // BDD variable orders shared among networks whose inputs are identified by keys
+  class OrderTable {
+  private:
+    // data
+    std::map<int, double> mKey2Pos; // relative level in [0, 1) of last exported order
+    std::string design; // name of network whose node ids are keys
+    int nPis;
+    int nNodes;
+    bool fRenumbered; // keys no longer match ids of network as read
+#ifdef ABC_USE_PTHREADS
+    std::mutex mutexTable;
+#endif
+
+  public:
+    // constructors
+    OrderTable();
+
+    // network (ids of nodes used as keys)
+    void Stamp(std::string design_, int nPis_, int nNodes_);
+    void Rekey(std::map<int, int> const &mOld2New);
+    void Clear();
+
+    // orders (import returns false if no key is known)
+    template <typename T>
+    bool Import(std::vector<int> const &vKeys, std::vector<T> &vVar2Level);
+    template <typename T>
+    void Export(std::vector<int> const &vKeys, std::vector<T> const &vVar2Level);
+
+    // file
+    void Read(std::string filename);
+    void Write(std::string filename);
+  };
+
+  /* {{{ Constructors */
+
+  inline OrderTable::OrderTable() :
+    nPis(0),
+    nNodes(0),
+    fRenumbered(false) {
+  }
+
+  /* }}} */
+
+  /* {{{ Network */
+
+  inline void OrderTable::Stamp(std::string design_, int nPis_, int nNodes_) {
+    design = design_;
+    nPis = nPis_;
+    nNodes = nNodes_;
+  }
+
+  inline void OrderTable::Rekey(std::map<int, int> const &mOld2New) {
+#ifdef ABC_USE_PTHREADS
+    std::unique_lock<std::mutex> l(mutexTable);
+#endif
+    // old entries are kept, as old nodes are dead but exist in network as read
+    for(auto const &entry: mOld2New) {
+      std::map<int, double>::const_iterator it = mKey2Pos.find(entry.first);
+      if(it != mKey2Pos.end() && !mKey2Pos.count(entry.second)) {
+        mKey2Pos[entry.second] = it->second;
+      }
+    }
+  }
+
+  inline void OrderTable::Clear() {
+#ifdef ABC_USE_PTHREADS
+    std::unique_lock<std::mutex> l(mutexTable);
+#endif
+    mKey2Pos.clear();
+    fRenumbered = true;
+  }
+
+  /* }}} */
+
+  /* {{{ Orders */
+
+  template <typename T>
+  bool OrderTable::Import(std::vector<int> const &vKeys, std::vector<T> &vVar2Level) {
+    int n = int_size(vKeys);
+    std::vector<double> vPos(n);
+    bool fKnown = false;
+    {
+#ifdef ABC_USE_PTHREADS
+      std::unique_lock<std::mutex> l(mutexTable);
+#endif
+      for(int i = 0; i < n; i++) {
+        std::map<int, double>::const_iterator it = mKey2Pos.find(vKeys[i]);
+        if(it != mKey2Pos.end()) {
+          vPos[i] = it->second;
+          fKnown = true;
+        } else {
+          // unknown inputs keep their relative position
+          vPos[i] = (double)i / n;
+        }
+      }
+    }
+    if(!fKnown) {
+      return false;
+    }
+    std::vector<int> vVars(n);
+    for(int i = 0; i < n; i++) {
+      vVars[i] = i;
+    }
+    std::stable_sort(vVars.begin(), vVars.end(), [&](int i, int j) {
+      return vPos[i] < vPos[j];
+    });
+    vVar2Level.resize(n);
+    for(int l = 0; l < n; l++) {
+      vVar2Level[vVars[l]] = l;
+    }
+    return true;
+  }
+
+  template <typename T>
+  void OrderTable::Export(std::vector<int> const &vKeys, std::vector<T> const &vVar2Level) {
+    assert(vKeys.size() == vVar2Level.size());
+    int n = int_size(vKeys);
+#ifdef ABC_USE_PTHREADS
+    std::unique_lock<std::mutex> l(mutexTable);
+#endif
+    for(int i = 0; i < n; i++) {
+      mKey2Pos[vKeys[i]] = (double)vVar2Level[i] / n;
+    }
+  }
+
+  /* }}} */
+
+  /* {{{ File */
+
+  inline void OrderTable::Read(std::string filename) {
+    // missing file is not an error, as it is written at the end of first run
+    std::ifstream f(filename);
+    if(!f) {
+      return;
+    }
+    int nPis_ = -1, nNodes_ = -1;
+    std::string design_;
+    f >> nPis_ >> nNodes_;
+    std::getline(f, design_);
+    if(!design_.empty() && design_[0] == ' ') {
+      design_.erase(0, 1);
+    }
+    if(nPis_ != nPis || nNodes_ != nNodes || design_ != design) {
+      PrintWarning("ignored BDD variable orders of different network in " + filename);
+      return;
+    }
+    int key;
+    double pos;
+    while(f >> key >> pos) {
+      mKey2Pos[key] = pos;
+    }
+  }
+
+  inline void OrderTable::Write(std::string filename) {
+    if(fRenumbered) {
+      PrintWarning("BDD variable orders are not written as network has been renumbered");
+      return;
+    }
+    std::ofstream f(filename);
+    if(!f) {
+      PrintWarning("failed to write BDD variable orders to " + filename);
+      return;
+    }
+    f << nPis << " " << nNodes << " " << design << std::endl;
+    for(auto const &entry: mKey2Pos) {
+      // nodes created during run are numbered differently next time
+      if(entry.first >= nNodes) {
+        continue;
+      }
+      f << entry.first << " " << entry.second << std::endl;
+    }
+  }
+
+  /* }}} */
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+#include "misc/rrrUtils.h"
+
+namespace rrr {
+
+  // arrays of fixed-width slots of each node packed in a single vector;
+  // elements outside arrays are always null so that data can be scanned as a whole
+  template <typename T>
+  class Slab {
+  private:
+    using itr = typename std::vector<T>::iterator;
+    using citr = typename std::vector<T>::const_iterator;
+    int width;
+    T null;
+    int nslots;
+    int ngarbage;
+    std::vector<T> data;
+    std::vector<int> begins;
+    std::vector<int> sizes;
+    std::vector<int> caps;
+
+    void Compact() {
+      std::vector<T> data2(data.size(), null);
+      int n = 0;
+      for(int id = 0; id < int_size(begins); id++) {
+        std::copy(data.begin() + begins[id] * width, data.begin() + (begins[id] + sizes[id]) * width, data2.begin() + n * width);
+        begins[id] = n;
+        caps[id] = sizes[id];
+        n += sizes[id];
+      }
+      data.swap(data2);
+      nslots = n;
+      ngarbage = 0;
+    }
+
+    void Grow(int id, int n) {
+      if(n <= caps[id]) {
+        return;
+      }
+      int cap = std::max(n, caps[id] << 1);
+      if(begins[id] + caps[id] == nslots) {
+        // last array can be extended in place
+        nslots = begins[id] + cap;
+        caps[id] = cap;
+        if(int_size(data) < nslots * width) {
+          data.resize(nslots * width, null);
+        }
+        return;
+      }
+      if(ngarbage > nslots - ngarbage) {
+        Compact();
+        if(begins[id] + caps[id] == nslots) {
+          Grow(id, n);
+          return;
+        }
+      }
+      if(int_size(data) < (nslots + cap) * width) {
+        data.resize((nslots + cap) * width, null);
+      }
+      itr it = data.begin() + begins[id] * width;
+      std::copy(it, it + sizes[id] * width, data.begin() + nslots * width);
+      std::fill(it, it + sizes[id] * width, null);
+      ngarbage += caps[id];
+      begins[id] = nslots;
+      caps[id] = cap;
+      nslots += cap;
+    }
+
+  public:
+    Slab(int width = 1, T null = T()) :
+      width(width),
+      null(null),
+      nslots(0),
+      ngarbage(0) {
+    }
+
+    // number of nodes
+    void Allocate(int nNodes) {
+      begins.resize(nNodes, nslots);
+      sizes.resize(nNodes);
+      caps.resize(nNodes);
+    }
+
+    // bulk reset keeping memory (elements must have been released)
+    void Reset(int width_) {
+      width = width_;
+      nslots = 0;
+      ngarbage = 0;
+      data.clear();
+      std::fill(begins.begin(), begins.end(), 0);
+      std::fill(sizes.begin(), sizes.end(), 0);
+      std::fill(caps.begin(), caps.end(), 0);
+    }
+
+    int Size(int id) const {
+      return sizes[id];
+    }
+
+    itr Get(int id, int idx) {
+      return data.begin() + (begins[id] + idx) * width;
+    }
+
+    citr Get(int id, int idx) const {
+      return data.begin() + (begins[id] + idx) * width;
+    }
+
+    std::vector<T> const &GetData() const {
+      return data;
+    }
+
+    // new slots are null
+    void Resize(int id, int n) {
+      if(n < sizes[id]) {
+        std::fill(Get(id, n), Get(id, sizes[id]), null);
+      } else {
+        Grow(id, n);
+      }
+      sizes[id] = n;
+    }
+
+    void Clear(int id) {
+      Resize(id, 0);
+    }
+
+    void Insert(int id, int idx, int n = 1) {
+      assert(idx <= sizes[id]);
+      Grow(id, sizes[id] + n);
+      std::copy_backward(Get(id, idx), Get(id, sizes[id]), Get(id, sizes[id] + n));
+      std::fill(Get(id, idx), Get(id, idx + n), null);
+      sizes[id] += n;
+    }
+
+    // erased elements are overwritten without being released
+    void Erase(int id, int idx, int n = 1) {
+      assert(idx + n <= sizes[id]);
+      std::copy(Get(id, idx + n), Get(id, sizes[id]), Get(id, idx));
+      std::fill(Get(id, sizes[id] - n), Get(id, sizes[id]), null);
+      sizes[id] -= n;
+    }
+  };
+
+}
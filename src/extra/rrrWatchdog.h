@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+
+#ifdef ABC_USE_PTHREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "misc/rrrUtils.h"
+
+namespace rrr {
+
+  // stop flag raised at timeout or on request, polled down to SAT solvers and BDD managers
+  class Watchdog {
+  private:
+    // pollers read stop flag through plain int pointer
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free, "atomic int must be laid out as int");
+
+    // parameters
+    seconds nTimeout;
+
+    // data
+    time_point timeStart;
+    std::atomic<int> fStop;
+#ifdef ABC_USE_PTHREADS
+    bool fFinished;
+    std::thread tWatchdog;
+    std::mutex mutexStop;
+    std::condition_variable condStop;
+#endif
+
+  public:
+    // constructors
+    Watchdog(seconds nTimeout);
+    ~Watchdog();
+
+    // control
+    void Start(); // starts clock, and thread raising stop flag at timeout
+    void Finish();
+    void Stop(); // may be called from another thread
+
+    // status
+    int *GetStopFlag();
+    bool IsStopped() const;
+    seconds GetRemainingTime() const; // 0 if unlimited, -1 if stopped
+    double GetElapsedTime() const;
+  };
+
+  /* {{{ Constructors */
+
+  inline Watchdog::Watchdog(seconds nTimeout) :
+    nTimeout(nTimeout),
+    timeStart(GetCurrentTime()),
+    fStop(0) {
+  }
+
+  inline Watchdog::~Watchdog() {
+    Finish();
+  }
+
+  /* }}} */
+
+  /* {{{ Control */
+
+  inline void Watchdog::Start() {
+    timeStart = GetCurrentTime();
+#ifdef ABC_USE_PTHREADS
+    if(nTimeout == 0) {
+      return;
+    }
+    fFinished = false;
+    tWatchdog = std::thread([&]() {
+      std::unique_lock<std::mutex> l(mutexStop);
+      if(!condStop.wait_until(l, timeStart + std::chrono::seconds(nTimeout), [&]() { return fFinished; })) {
+        Stop();
+      }
+    });
+#endif
+  }
+
+  inline void Watchdog::Finish() {
+#ifdef ABC_USE_PTHREADS
+    if(!tWatchdog.joinable()) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> l(mutexStop);
+      fFinished = true;
+      condStop.notify_one();
+    }
+    tWatchdog.join();
+#endif
+  }
+
+  inline void Watchdog::Stop() {
+    fStop = 1;
+  }
+
+  /* }}} */
+
+  /* {{{ Status */
+
+  inline int *Watchdog::GetStopFlag() {
+    return reinterpret_cast<int *>(&fStop);
+  }
+
+  inline bool Watchdog::IsStopped() const {
+    return fStop;
+  }
+
+  inline seconds Watchdog::GetRemainingTime() const {
+    if(fStop) {
+      return -1;
+    }
+    if(nTimeout == 0) {
+      return 0;
+    }
+    time_point timeCurrent = GetCurrentTime();
+    seconds nRemainingTime = nTimeout - DurationInSeconds(timeStart, timeCurrent);
+    if(nRemainingTime == 0) { // avoid glitch
+      return -1;
+    }
+    return nRemainingTime;
+  }
+
+  inline double Watchdog::GetElapsedTime() const {
+    time_point timeCurrent = GetCurrentTime();
+    return Duration(timeStart, timeCurrent);
+  }
+
+  /* }}} */
+
+}
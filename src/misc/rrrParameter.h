@@ -20,7 +20,19 @@ namespace rrr {
     bool fUseBddResim = false;
     bool fUseTt = false;
     bool fUseTtResim = false;
+    bool fUseAuto = false;
+    bool fUseSignature = false;
+    bool fUseCore = false;
+    bool fMinimizeCore = false;
     int nConflictLimit = 0;
+    int nSatWindowDepth = 0;
+    int nSatBackend = 0;
+    int nSatPortfolio = 0;
+    int nSatPortfolioConflictLimit = 0;
+    int nSatCexes = 0;
+    int nConflictPercentile = 0;
+    int nConflictRetries = 0;
+    int nSatCacheSize = 0;
     int nSortType = -1;
     int nOptimizerFlow = 0;
     int nSchedulerFlow = 0;
@@ -52,6 +64,9 @@ namespace rrr {
     int nRelaxOnRemoval = 0;
     bool fNoRelax = false;
     int nTemperatureSchedule = 0;
+    int nCustomCondition = 0;
+    int nClasses = 10;
+    int nHammingBudget = 0;
     std::string strTemporary;
     std::string strPattern;
     std::string strPatternOutput;
@@ -59,6 +74,8 @@ namespace rrr {
     std::string strPatternLabel;
     std::string strCond;
     std::string strOutput;
+    std::string strBddOrder;
+    std::string strDesign;
   };
   
 }
@@ -7,6 +7,8 @@
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
 
 namespace rrr {
 
@@ -36,9 +38,12 @@ namespace rrr {
     int nSamples;
     bool fCompatible;
     bool fGreedy;
+    bool fUseSignature;
+    bool fUseCore;
     std::string strTemporary;
     seconds nTimeout; // assigned upon Run
     std::function<void(std::string)> PrintLine;
+    int *pStop; // run ends once this becomes nonzero
 
     int nTargets = 3;
 
@@ -56,6 +61,8 @@ namespace rrr {
     // marks
     int target;
     std::vector<bool> vTfoMarks;
+    std::vector<int> vSigCands;
+    std::vector<int> vCandMarks; // 1 << c if edge of polarity c may be feasible
 
     // statistics
     struct Stats;
@@ -72,6 +79,10 @@ namespace rrr {
     // topology
     void MarkTfo(int id);
 
+    // candidates
+    bool MarkCandidates(int id);
+    void UnmarkCandidates();
+
     // time
     bool Timeout();
 
@@ -128,6 +139,9 @@ namespace rrr {
     Optimizer(Parameter const *pPar, std::function<double(Ntk *)> CostFunction);
     void AssignNetwork(Ntk *pNtk_, bool fReuse = false);
     void SetPrintLine(std::function<void(std::string)> const &PrintLine_);
+    void SetStop(int *pStop_); // also interrupts in-flight queries of analyzer
+    void SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys); // BDD variable orders keyed by input identities
+    void SetBddBase(BddBase *pBase); // BDD manager shared by copies of network
 
     // run
     void Run(int iSeed = 0, seconds nTimeout_ = 0);
@@ -282,10 +296,37 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Candidates */
+
+  template <typename Ntk, typename Ana>
+  inline bool Optimizer<Ntk, Ana>::MarkCandidates(int id) {
+    // marks edges that analyzer cannot reject by simulation
+    if(!fUseSignature || !ana.GetCandidates(id, vSigCands, pNtk->UseComplementedEdges())) {
+      return false;
+    }
+    vCandMarks.resize(pNtk->GetNumNodes());
+    for(int cand: vSigCands) {
+      vCandMarks[cand >> 1] |= 1 << (cand & 1);
+    }
+    return true;
+  }
+
+  template <typename Ntk, typename Ana>
+  inline void Optimizer<Ntk, Ana>::UnmarkCandidates() {
+    for(int cand: vSigCands) {
+      vCandMarks[cand >> 1] = 0;
+    }
+  }
+
+  /* }}} */
+
   /* {{{ Time */
   
   template <typename Ntk, typename Ana>
   inline bool Optimizer<Ntk, Ana>::Timeout() {
+    if(pStop && *pStop) {
+      return true;
+    }
     if(nTimeout) {
       time_point current = GetCurrentTime();
       if(DurationInSeconds(start, current) > nTimeout) {
@@ -561,6 +602,21 @@ namespace rrr {
   inline bool Optimizer<Ntk, Ana>::RemoveRedundantFanins(int id, bool fRemoveUnused) {
     assert(pNtk->GetNumFanouts(id) > 0);
     bool fReduced = false;
+    // remove fanins together first if supported, and then check the rest one by one
+    if(fUseCore && pNtk->GetNumFanins(id) > 2 && ana.GetRedundantFanins(id, vTmp)) {
+      for(critr it = vTmp.rbegin(); it != vTmp.rend(); it++) {
+        int fi = pNtk->GetFanin(id, *it);
+        // skip fanins that were just added
+        if(mapNewFanins.count(id) && mapNewFanins[id].count(fi)) {
+          continue;
+        }
+        pNtk->RemoveFanin(id, *it);
+        fReduced = true;
+        if(fRemoveUnused && pNtk->IsInt(fi) && pNtk->GetNumFanouts(fi) == 0) {
+          pNtk->RemoveUnused(fi, true);
+        }
+      }
+    }
     for(int idx = 0; idx < pNtk->GetNumFanins(id); idx++) {
       // skip fanins that were just added
       if(mapNewFanins.count(id)) {
@@ -809,6 +865,7 @@ namespace rrr {
     pNtk->ForEachFanin(id, [&](int fi) {
       vTfoMarks[fi] = true;
     });
+    bool fFiltered = MarkCandidates(id);
     T it = begin;
     for(; it != end; it++) {
       if(!pNtk->IsInt(*it) && !pNtk->IsPi(*it)) {
@@ -817,11 +874,14 @@ namespace rrr {
       if(vTfoMarks[*it]) {
         continue;
       }
+      if(fFiltered && !vCandMarks[*it]) {
+        continue;
+      }
       statsLocal.nTriedFis++;
-      if(ana.CheckFeasibility(id, *it, false)) {
+      if((!fFiltered || (vCandMarks[*it] & 1)) && ana.CheckFeasibility(id, *it, false)) {
         pNtk->AddFanin(id, *it, false);
         statsLocal.nAddedFis++;
-      } else if(pNtk->UseComplementedEdges() && ana.CheckFeasibility(id, *it, true)) {
+      } else if(pNtk->UseComplementedEdges() && (!fFiltered || (vCandMarks[*it] & 2)) && ana.CheckFeasibility(id, *it, true)) {
         pNtk->AddFanin(id, *it, true);
         statsLocal.nAddedFis++;
       } else {
@@ -833,6 +893,9 @@ namespace rrr {
     pNtk->ForEachFanin(id, [&](int fi) {
       vTfoMarks[fi] = false;
     });
+    if(fFiltered) {
+      UnmarkCandidates();
+    }
     time_point timeEnd = GetCurrentTime();
     statsLocal.durationAdd += Duration(timeStart, timeEnd);
     return it;
@@ -845,6 +908,7 @@ namespace rrr {
     pNtk->ForEachFanin(id, [&](int fi) {
       vTfoMarks[fi] = true;
     });
+    bool fFiltered = MarkCandidates(id);
     int nAddedFis_ = 0;
     for(int cand: vCands) {
       if(!pNtk->IsInt(cand) && !pNtk->IsPi(cand)) {
@@ -853,11 +917,14 @@ namespace rrr {
       if(vTfoMarks[cand]) {
         continue;
       }
+      if(fFiltered && !vCandMarks[cand]) {
+        continue;
+      }
       statsLocal.nTriedFis++;
-      if(ana.CheckFeasibility(id, cand, false)) {
+      if((!fFiltered || (vCandMarks[cand] & 1)) && ana.CheckFeasibility(id, cand, false)) {
         pNtk->AddFanin(id, cand, false);
         statsLocal.nAddedFis++;
-      } else if(pNtk->UseComplementedEdges() && ana.CheckFeasibility(id, cand, true)) {
+      } else if(pNtk->UseComplementedEdges() && (!fFiltered || (vCandMarks[cand] & 2)) && ana.CheckFeasibility(id, cand, true)) {
         pNtk->AddFanin(id, cand, true);
         statsLocal.nAddedFis++;
       } else {
@@ -872,6 +939,9 @@ namespace rrr {
     pNtk->ForEachFanin(id, [&](int fi) {
       vTfoMarks[fi] = false;
     });
+    if(fFiltered) {
+      UnmarkCandidates();
+    }
     time_point timeEnd = GetCurrentTime();
     statsLocal.durationAdd += Duration(timeStart, timeEnd);
     return nAddedFis_;
@@ -1430,7 +1500,10 @@ namespace rrr {
     nSamples(pPar->nSamples),
     fCompatible(pPar->fUseBddCspf),
     fGreedy(pPar->fGreedy),
+    fUseSignature(pPar->fUseSignature),
+    fUseCore(pPar->fUseCore),
     strTemporary(pPar->strTemporary),
+    pStop(NULL),
     ana(pPar),
     target(-1) {
   }
@@ -1447,6 +1520,22 @@ namespace rrr {
   void Optimizer<Ntk, Ana>::SetPrintLine(std::function<void(std::string)> const &PrintLine_) {
     PrintLine = PrintLine_;
   }
+
+  template <typename Ntk, typename Ana>
+  void Optimizer<Ntk, Ana>::SetStop(int *pStop_) {
+    pStop = pStop_;
+    ana.SetStop(pStop);
+  }
+
+  template <typename Ntk, typename Ana>
+  void Optimizer<Ntk, Ana>::SetOrderTable(OrderTable *pOrders, std::vector<int> const &vKeys) {
+    ana.SetOrderTable(pOrders, vKeys);
+  }
+
+  template <typename Ntk, typename Ana>
+  void Optimizer<Ntk, Ana>::SetBddBase(BddBase *pBase) {
+    ana.SetBddBase(pBase);
+  }
   
   /* }}} */
 
@@ -1463,6 +1552,7 @@ namespace rrr {
     }
     nTimeout = nTimeout_;
     start = GetCurrentTime();
+    ana.SetTimeBudget(start, nTimeout);
     if(fSortInitial) {
       SortFanins();
     }
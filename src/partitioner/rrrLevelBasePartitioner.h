@@ -45,7 +45,8 @@ namespace rrr {
 
     // APIs
     Ntk *Extract(int iSeed);
-    void Insert(Ntk *pSubNtk);
+    std::map<int, int> Insert(Ntk *pSubNtk); // returns new ids of updated outputs
+    std::vector<int> GetInputs(Ntk *pSubNtk);
   };
 
   /* {{{ Print */
@@ -252,7 +253,7 @@ namespace rrr {
   }
 
   template <typename Ntk>
-  void LevelBasePartitioner<Ntk>::Insert(Ntk *pSubNtk) {
+  std::map<int, int> LevelBasePartitioner<Ntk>::Insert(Ntk *pSubNtk) {
     for(int i: std::get<0>(mSubNtk2Io[pSubNtk])) {
       sBlocked.erase(i);
     }
@@ -278,10 +279,22 @@ namespace rrr {
         }
       }
     }
+    std::map<int, int> mOld2New;
+    for(int idx = 0; idx < int_size(vOldOutputs); idx++) {
+      if(vNewOutputs[idx] != vOldOutputs[idx]) {
+        mOld2New[vOldOutputs[idx]] = vNewOutputs[idx];
+      }
+    }
     delete pSubNtk;
     mSubNtk2Io.erase(pSubNtk);
     vFailed.clear(); // clear, there isn't really a way to track
     vLevels.clear();
+    return mOld2New;
+  }
+
+  template <typename Ntk>
+  std::vector<int> LevelBasePartitioner<Ntk>::GetInputs(Ntk *pSubNtk) {
+    return std::get<1>(mSubNtk2Io[pSubNtk]);
   }
 
   /* }}} */
@@ -46,7 +46,7 @@ namespace rrr {
 
     // APIs
     Ntk *Extract(int iSeed);
-    void Insert(Ntk *pSubNtk);
+    std::map<int, int> Insert(Ntk *pSubNtk); // returns new ids of updated outputs
     std::vector<int> GetInputs(Ntk *pSubNtk);
     bool IsTooSmall(Ntk *pNtk_);
   };
@@ -326,7 +326,7 @@ namespace rrr {
   }
 
   template <typename Ntk>
-  void Partitioner<Ntk>::Insert(Ntk *pSubNtk) {
+  std::map<int, int> Partitioner<Ntk>::Insert(Ntk *pSubNtk) {
     for(int i: std::get<0>(mSubNtk2Io[pSubNtk])) {
       sBlocked.erase(i);
     }
@@ -352,9 +352,16 @@ namespace rrr {
         }
       }
     }
+    std::map<int, int> mOld2New;
+    for(int idx = 0; idx < int_size(vOldOutputs); idx++) {
+      if(vNewOutputs[idx] != vOldOutputs[idx]) {
+        mOld2New[vOldOutputs[idx]] = vNewOutputs[idx];
+      }
+    }
     delete pSubNtk;
     mSubNtk2Io.erase(pSubNtk);
     vFailed.clear(); // clear, there isn't really a way to track
+    return mOld2New;
   }
 
   template <typename Ntk>
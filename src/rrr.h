@@ -7,6 +7,8 @@
 #include "analyzer/rrrBddCspfAnalyzer.h"
 #include "analyzer/rrrBddMspfAnalyzer.h"
 #include "analyzer/rrrBddResimAnalyzer.h"
+#include "analyzer/rrrBddFallbackAnalyzer.h"
+#include "analyzer/rrrAutoAnalyzer.h"
 #include "analyzer/rrrAnalyzer.h"
 #include "analyzer/sat/rrrSatSolver.h"
 #include "analyzer/sat/rrrSatSolver2.h"
@@ -27,14 +29,17 @@ namespace rrr {
     } else if(pPar->fUseTt) {
       Sch<Ntk, Opt<Ntk, TtAnalyzer<Ntk, DcSimulator<Ntk>>>, Par<Ntk>> sch(pNtk, pPar);
       sch.Run();
+    } else if(pPar->fUseAuto) {
+      Sch<Ntk, Opt<Ntk, AutoAnalyzer<Ntk, TtAnalyzer<Ntk, DcSimulator<Ntk>>, BddFallbackAnalyzer<Ntk, BddMspfAnalyzer<Ntk>, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>>, Par<Ntk>> sch(pNtk, pPar);
+      sch.Run();
     } else if(pPar->fUseBddResim) {
-      Sch<Ntk, Opt<Ntk, BddResimAnalyzer<Ntk>>, Par<Ntk>> sch(pNtk, pPar);
+      Sch<Ntk, Opt<Ntk, BddFallbackAnalyzer<Ntk, BddResimAnalyzer<Ntk>, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>>, Par<Ntk>> sch(pNtk, pPar);
       sch.Run();
     } else if(pPar->fUseBddCspf) {
-      Sch<Ntk, Opt<Ntk, BddCspfAnalyzer<Ntk>>, Par<Ntk>> sch(pNtk, pPar);
+      Sch<Ntk, Opt<Ntk, BddFallbackAnalyzer<Ntk, BddCspfAnalyzer<Ntk>, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>>, Par<Ntk>> sch(pNtk, pPar);
       sch.Run();
     } else if(pPar->fUseBddMspf) {
-      Sch<Ntk, Opt<Ntk, BddMspfAnalyzer<Ntk>>, Par<Ntk>> sch(pNtk, pPar);
+      Sch<Ntk, Opt<Ntk, BddFallbackAnalyzer<Ntk, BddMspfAnalyzer<Ntk>, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>>, Par<Ntk>> sch(pNtk, pPar);
       sch.Run();
     } else {
       Sch<Ntk, Opt<Ntk, Analyzer<Ntk, Simulator<Ntk>, SatSolver2<Ntk>>>, Par<Ntk>> sch(pNtk, pPar);
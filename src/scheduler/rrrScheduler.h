@@ -13,6 +13,9 @@
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
 #include "interface/rrrAbc.h"
+#include "extra/rrrOrderTable.h"
+#include "extra/rrrBddBase.h"
+#include "extra/rrrWatchdog.h"
 
 namespace rrr {
 
@@ -39,14 +42,16 @@ namespace rrr {
     bool fDeterministic;
     int nParallelPartitions;
     bool fOptOnInsert;
-    seconds nTimeout;
+    std::string strBddOrder;
     std::function<double(Ntk *)> CostFunction;
     
     // data
     int nCreatedJobs;
     int nFinishedJobs;
-    time_point timeStart;
+    Watchdog watchdog;
     Par par;
+    OrderTable orders; // BDD variable orders shared among jobs
+    BddBase base; // BDD manager of whole network, copied by concurrent jobs
     std::queue<Job *> qPendingJobs;
     Opt *pOpt; // used only in case of single thread execution
     std::vector<std::string> vStatsSummaryKeys;
@@ -69,10 +74,6 @@ namespace rrr {
     template <typename... Args>
     void Print(int nVerboseLevel, std::string prefix, Args... args);
     
-    // time
-    seconds GetRemainingTime() const;
-    double GetElapsedTime() const;
-
     // abc
     void CallAbc(Ntk *pNtk_, std::string Command);
 
@@ -99,6 +100,7 @@ namespace rrr {
     
     // run
     void Run();
+    void Stop(); // may be called from another thread
   };
 
   /* {{{ Job */
@@ -110,6 +112,7 @@ namespace rrr {
     Ntk *pNtk;
     int iSeed;
     double costInitial;
+    std::vector<int> vPiKeys; // keys of inputs in order table
     std::string prefix;
     double duration;
     summary<int> stats;
@@ -163,29 +166,6 @@ namespace rrr {
 
   /* }}} */
   
-  /* {{{ Time */
-
-  template <typename Ntk, typename Opt, typename Par>
-  inline seconds Scheduler<Ntk, Opt, Par>::GetRemainingTime() const {
-    if(nTimeout == 0) {
-      return 0;
-    }
-    time_point timeCurrent = GetCurrentTime();
-    seconds nRemainingTime = nTimeout - DurationInSeconds(timeStart, timeCurrent);
-    if(nRemainingTime == 0) { // avoid glitch
-      return -1;
-    }
-    return nRemainingTime;
-  }
-
-  template <typename Ntk, typename Opt, typename Par>
-  inline double Scheduler<Ntk, Opt, Par>::GetElapsedTime() const {
-    time_point timeCurrent = GetCurrentTime();
-    return Duration(timeStart, timeCurrent);
-  }
-
-  /* }}} */
-
   /* {{{ Abc */
 
   template <typename Ntk, typename Opt, typename Par>
@@ -209,6 +189,9 @@ namespace rrr {
   template <typename Ntk, typename Opt, typename Par>
   void Scheduler<Ntk, Opt, Par>::RunJob(Opt &opt, Job *pJob) {
     time_point timeStartLocal = GetCurrentTime();
+    opt.SetOrderTable(&orders, pJob->vPiKeys);
+    // copies of whole network start from same BDDs, while partitions have different inputs
+    opt.SetBddBase(fMultiThreading && !fPartitioning && nJobs > 1? &base: NULL);
     opt.AssignNetwork(pJob->pNtk, !fPartitioning); // reuse backend if restarting
     opt.SetPrintLine([&](std::string str) {
       Print(-1, pJob->prefix, str);
@@ -217,7 +200,7 @@ namespace rrr {
     // start flow
     switch(nFlow) {
     case 0:
-      opt.Run(pJob->iSeed, GetRemainingTime());
+      opt.Run(pJob->iSeed, watchdog.GetRemainingTime());
       break;
     case 1: { // transtoch
       std::mt19937 rng(pJob->iSeed);
@@ -225,7 +208,7 @@ namespace rrr {
       double costBest = cost;
       int slot = pJob->pNtk->Save();
       for(int i = 0; i < 10; i++) {
-        if(GetRemainingTime() < 0) {
+        if(watchdog.GetRemainingTime() < 0) {
           break;
         }
         if(i != 0) {
@@ -234,10 +217,10 @@ namespace rrr {
           Print(1, pJob->prefix, "hop", i, ":", "cost", "=", cost);
         }
         for(int j = 0; true; j++) {
-          if(GetRemainingTime() < 0) {
+          if(watchdog.GetRemainingTime() < 0) {
             break;
           }
-          opt.Run(rng(), GetRemainingTime());
+          opt.Run(rng(), watchdog.GetRemainingTime());
           CallAbc(pJob->pNtk, "&dc2");
           double costNew = CostFunction(pJob->pNtk);
           Print(1, pJob->prefix, "ite", j, ":", "cost", "=", costNew);
@@ -267,7 +250,7 @@ namespace rrr {
       double cost = pJob->costInitial;
       int slot = pJob->pNtk->Save();
       for(int i = 0; i < 1000000; i++) {
-        if(GetRemainingTime() < 0) {
+        if(watchdog.GetRemainingTime() < 0) {
           break;
         }
         // deepsyn
@@ -298,10 +281,10 @@ namespace rrr {
         Print(1, pJob->prefix, "ite", i, ":", "cost", "=", CostFunction(pJob->pNtk));
         // rrr
         for(int j = 0; j < n; j++) {
-          if(GetRemainingTime() < 0) {
+          if(watchdog.GetRemainingTime() < 0) {
             break;
           }
-          opt.Run(rng2(), GetRemainingTime());
+          opt.Run(rng2(), watchdog.GetRemainingTime());
           if(rng2() & 1) {
             CallAbc(pJob->pNtk, "&dc2");
           } else {
@@ -323,12 +306,12 @@ namespace rrr {
       break;
     }
     case 3:
-      opt.Run(pJob->iSeed, GetRemainingTime());
+      opt.Run(pJob->iSeed, watchdog.GetRemainingTime());
       CallAbc(pJob->pNtk, std::string("&put; ") + pCompress2rs + "; dc2; &get");
       break;
     case 4: {
       for(int i = 0; i < 100; i++) {
-        opt.Run(pJob->iSeed, GetRemainingTime());
+        opt.Run(pJob->iSeed, watchdog.GetRemainingTime());
         time_point timeAbcStart = GetCurrentTime();
         CallAbc(pJob->pNtk, std::string("&put; ") + pCompress2rs + "; dc2; &get");
         time_point timeAbcEnd = GetCurrentTime();
@@ -354,6 +337,12 @@ namespace rrr {
   template <typename Ntk, typename Opt, typename Par>
   typename Scheduler<Ntk, Opt, Par>::Job *Scheduler<Ntk, Opt, Par>::CreateJob(Ntk *pNtk_, int iSeed_, double cost) {
     Job *pJob = new Job(nCreatedJobs++, pNtk_, iSeed_, cost);
+    // inputs of partitions are nodes of whole network, while copies share inputs
+    if(fPartitioning) {
+      pJob->vPiKeys = par.GetInputs(pNtk_);
+    } else {
+      pJob->vPiKeys = pNtk_->GetPis();
+    }
 #ifdef ABC_USE_PTHREADS
     if(fMultiThreading) {
       {
@@ -411,6 +400,7 @@ namespace rrr {
   void Scheduler<Ntk, Opt, Par>::Thread(Parameter const *pPar) {
     Abc_Start();
     Opt opt(pPar, CostFunction);
+    opt.SetStop(watchdog.GetStopFlag());
     while(true) {
       Job *pJob = NULL;
       {
@@ -475,9 +465,10 @@ namespace rrr {
     fDeterministic(pPar->fDeterministic),
     nParallelPartitions(pPar->nParallelPartitions),
     fOptOnInsert(pPar->fOptOnInsert),
-    nTimeout(pPar->nTimeout),
+    strBddOrder(pPar->strBddOrder),
     nCreatedJobs(0),
     nFinishedJobs(0),
+    watchdog(pPar->nTimeout),
     par(pPar),
     pOpt(NULL) {
     // prepare cost function
@@ -488,6 +479,10 @@ namespace rrr {
       });
       return nTwoInputSize;
     };
+    if(!strBddOrder.empty()) {
+      orders.Stamp(pPar->strDesign, pNtk->GetNumPis(), pNtk->GetNumNodes());
+      orders.Read(strBddOrder);
+    }
 #ifdef ABC_USE_PTHREADS
     fTerminate = false;
     if(fMultiThreading) {
@@ -500,6 +495,7 @@ namespace rrr {
 #endif
     assert(!fMultiThreading);
     pOpt = new Opt(pPar, CostFunction);
+    pOpt->SetStop(watchdog.GetStopFlag());
     Abc_Start();
   }
 
@@ -528,14 +524,14 @@ namespace rrr {
 
   template <typename Ntk, typename Opt, typename Par>
   void Scheduler<Ntk, Opt, Par>::Run() {
-    timeStart = GetCurrentTime();
+    watchdog.Start();
     double costStart = CostFunction(pNtk);
     if(fPartitioning) {
       std::mt19937 rng(iSeed);      
       fDeterministic = false; // it is deterministic anyways as we wait until all jobs finish each round
       pNtk->Sweep();
       par.AssignNetwork(pNtk);
-      while(nCreatedJobs < nJobs) {
+      while(!watchdog.IsStopped() && nCreatedJobs < nJobs) {
         assert(nParallelPartitions > 0);
         if(nCreatedJobs < nFinishedJobs + nParallelPartitions) {
           Ntk *pSubNtk = par.Extract(rng());
@@ -553,29 +549,31 @@ namespace rrr {
           OnJobEnd([&](Job *pJob) {
             double cost = CostFunction(pJob->pNtk);
             Print(1, pJob->prefix, "finished", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost);
-            Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
-            par.Insert(pJob->pNtk);
+            Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
+            orders.Rekey(par.Insert(pJob->pNtk));
           });
         }
         if(fOptOnInsert) {
           time_point timeStartLocal = GetCurrentTime();
           CallAbc(pNtk, std::string("&put; ") + pCompress2rs + "; dc2; &get");
+          orders.Clear(); // nodes are renumbered
           time_point timeEndLocal = GetCurrentTime();
           par.AssignNetwork(pNtk);
           double cost = CostFunction(pNtk);
-          Print(0, "", "c2rs; dc2", ":", std::string(34, ' '), "node", "=", pNtk->GetNumInts(), ",", "level", "=", pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - costStart) / costStart, "%", ")", ",", "duration", "=", Duration(timeStartLocal, timeEndLocal), "s", ",", "elapsed", "=", GetElapsedTime(), "s");
+          Print(0, "", "c2rs; dc2", ":", std::string(34, ' '), "node", "=", pNtk->GetNumInts(), ",", "level", "=", pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - costStart) / costStart, "%", ")", ",", "duration", "=", Duration(timeStartLocal, timeEndLocal), "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
         }
       }
       while(nFinishedJobs < nCreatedJobs) {
         OnJobEnd([&](Job *pJob) {
           double cost = CostFunction(pJob->pNtk);
           Print(1, pJob->prefix, "finished", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", CostFunction(pJob->pNtk));
-          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
-          par.Insert(pJob->pNtk);
+          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
+          orders.Rekey(par.Insert(pJob->pNtk));
         });
       }
       if(fOptOnInsert) {
         CallAbc(pNtk, std::string("&put; ") + pCompress2rs + "; dc2; &get");
+        orders.Clear();
         par.AssignNetwork(pNtk);
       }
     } else if(nJobs > 1) {
@@ -587,7 +585,7 @@ namespace rrr {
       for(int i = 0; i < nJobs; i++) {
         OnJobEnd([&](Job *pJob) {
           double cost = CostFunction(pJob->pNtk);
-          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
+          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
           if(cost < costBest) {
             costBest = cost;
             pNtk->Read(*(pJob->pNtk));
@@ -599,11 +597,15 @@ namespace rrr {
       CreateJob(pNtk, iSeed, costStart);
       OnJobEnd([&](Job *pJob) {
         double cost = CostFunction(pJob->pNtk);
-        Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
+        Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
       });
     }
+    watchdog.Finish();
+    if(!strBddOrder.empty()) {
+      orders.Write(strBddOrder);
+    }
     double cost = CostFunction(pNtk);
-    double duration = GetElapsedTime();
+    double duration = watchdog.GetElapsedTime();
     Print(0, "\n", "stats summary", ":");
     for(std::string key: vStatsSummaryKeys) {
       Print(0, "\t", SW{30, true}, key, ":", SW{10}, mStatsSummary[key]);
@@ -615,6 +617,11 @@ namespace rrr {
     Print(0, "", "end", ":", "cost", "=", cost, "(", 100 * (cost - costStart) / costStart, "%", ")", ",", "time", "=", duration, "s");
   }
 
+  template <typename Ntk, typename Opt, typename Par>
+  void Scheduler<Ntk, Opt, Par>::Stop() {
+    watchdog.Stop();
+  }
+
   /* }}} */
 
 }
@@ -14,6 +14,7 @@
 #include "interface/rrrAbc.h"
 #include "interface/rrrMockturtle.h"
 #include "interface/rrrSystemCall.h"
+#include "extra/rrrWatchdog.h"
 
 #include "simulator/rrrSimulator2.h"
 
@@ -46,7 +47,6 @@ namespace rrr {
     bool fOptOnInsert;
     bool fNoGlobalJump;
     std::string strOutput;
-    seconds nTimeout;
     std::function<double(Ntk *)> CostFunction;
 
     int nPartitionSizeMin;
@@ -54,7 +54,7 @@ namespace rrr {
     // data
     int nCreatedJobs;
     int nFinishedJobs;
-    time_point timeStart;
+    Watchdog watchdog;
     std::queue<Job *> qPendingJobs;
     
     // used only in case of single thread execution
@@ -87,10 +87,6 @@ namespace rrr {
     template <typename... Args>
     void Print(int nVerboseLevel, std::string prefix, Args... args);
     
-    // time
-    seconds GetRemainingTime() const;
-    double GetElapsedTime() const;
-
     // scripts
     template <typename Rng>
     std::string AbcLocal(Rng &rng, bool fOdc);
@@ -124,6 +120,7 @@ namespace rrr {
     
     // run
     void Run();
+    void Stop(); // may be called from another thread
   };
 
   /* {{{ Job */
@@ -197,29 +194,6 @@ namespace rrr {
 
   /* }}} */
   
-  /* {{{ Time */
-
-  template <typename Ntk, typename Opt, typename Par>
-  inline seconds Scheduler3<Ntk, Opt, Par>::GetRemainingTime() const {
-    if(nTimeout == 0) {
-      return 0;
-    }
-    time_point timeCurrent = GetCurrentTime();
-    seconds nRemainingTime = nTimeout - DurationInSeconds(timeStart, timeCurrent);
-    if(nRemainingTime == 0) { // avoid glitch
-      return -1;
-    }
-    return nRemainingTime;
-  }
-
-  template <typename Ntk, typename Opt, typename Par>
-  inline double Scheduler3<Ntk, Opt, Par>::GetElapsedTime() const {
-    time_point timeCurrent = GetCurrentTime();
-    return Duration(timeStart, timeCurrent);
-  }
-
-  /* }}} */
-
   /* {{{ Scripts */
   
   template <typename Ntk, typename Opt, typename Par>
@@ -505,7 +479,7 @@ namespace rrr {
             opt.SetPrintLine([&](std::string str) {
               Print(-1, pJob->prefix, str);
             });
-            opt.Run(seed, GetRemainingTime());
+            opt.Run(seed, watchdog.GetRemainingTime());
             parOpt.Insert(pSubNtk);
             pJob->stats = opt.GetStatsSummary();
             pJob->times = opt.GetTimesSummary();
@@ -518,7 +492,7 @@ namespace rrr {
           opt.SetPrintLine([&](std::string str) {
             Print(-1, pJob->prefix, str);
           });
-          opt.Run(seed, GetRemainingTime());
+          opt.Run(seed, watchdog.GetRemainingTime());
           pJob->stats = opt.GetStatsSummary();
           pJob->times = opt.GetTimesSummary();
           opt.ResetSummary();
@@ -730,7 +704,7 @@ namespace rrr {
           opt.SetPrintLine([&](std::string str) {
             Print(-1, pJob->prefix, str);
           });
-          opt.Run(pJob->iSeed, GetRemainingTime());
+          opt.Run(pJob->iSeed, watchdog.GetRemainingTime());
           parOpt.Insert(pSubNtk);
           pJob->stats = opt.GetStatsSummary();
           pJob->times = opt.GetTimesSummary();
@@ -741,7 +715,7 @@ namespace rrr {
         opt.SetPrintLine([&](std::string str) {
           Print(-1, pJob->prefix, str);
         });
-        opt.Run(pJob->iSeed, GetRemainingTime());
+        opt.Run(pJob->iSeed, watchdog.GetRemainingTime());
         pJob->stats = opt.GetStatsSummary();
         pJob->times = opt.GetTimesSummary();
         opt.ResetSummary();
@@ -827,6 +801,7 @@ namespace rrr {
     Abc_Start();
     AbcLmsStart("lib6.aig");
     Opt opt(pPar, CostFunction);
+    opt.SetStop(watchdog.GetStopFlag());
     Par parOpt(pPar);
     Par parResyn(pPar->nResynVerbose, pPar->nResynSize, 0, pPar->nResynInputMax);
     Simulator2<Ntk> sim;
@@ -902,9 +877,9 @@ namespace rrr {
     fOptOnInsert(pPar->fOptOnInsert),
     fNoGlobalJump(pPar->fNoGlobalJump),
     strOutput(pPar->strOutput),
-    nTimeout(pPar->nTimeout),
     nCreatedJobs(0),
     nFinishedJobs(0),
+    watchdog(pPar->nTimeout),
     pOpt(NULL),
     pParOpt(NULL),
     pParResyn(NULL),
@@ -930,6 +905,7 @@ namespace rrr {
     assert(!fMultiThreading);
     AbcLmsStart("lib6.aig");
     pOpt = new Opt(pPar, CostFunction);
+    pOpt->SetStop(watchdog.GetStopFlag());
     pParOpt = new Par(pPar);
     pParResyn = new Par(pPar->nResynVerbose, pPar->nResynSize, 0, pPar->nResynInputMax);
     pSim = new Simulator2<Ntk>;
@@ -965,7 +941,7 @@ namespace rrr {
     constexpr bool fLog = false;
     constexpr bool fVerify = false;
     constexpr bool fPrint = false;
-    timeStart = GetCurrentTime();
+    watchdog.Start();
     double costStart = CostFunction(pNtk);
     pNtk->Sweep();
     double costBest = CostFunction(pNtk);
@@ -990,7 +966,7 @@ namespace rrr {
         backups.push_back(new Ntk(*vPopulation[i]));
       }
     }
-    while(GetRemainingTime() >= 0 && nCreatedJobs < nJobs) {
+    while(watchdog.GetRemainingTime() >= 0 && nCreatedJobs < nJobs) {
       // create jobs (jump if not first)
       for(int i = 0; i < nPopulation; i++) {
         Job *pJob;
@@ -1007,8 +983,8 @@ namespace rrr {
           // check
           double cost = CostFunction(pJob->pNtk);          
           Print(1, pJob->prefix, "finished", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost);
-          //Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
-	  Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", pJob->pNtk->GetNumInts(), ",", pJob->pNtk->GetNumLevels(), ",", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", pJob->column, ",", pJob->stage, ",", pJob->iteration, ",", pJob->last_impr, ",", pJob->duration, "s", ",", GetElapsedTime(), "s", ",", pJob->log);
+          //Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
+	  Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", pJob->pNtk->GetNumInts(), ",", pJob->pNtk->GetNumLevels(), ",", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", pJob->column, ",", pJob->stage, ",", pJob->iteration, ",", pJob->last_impr, ",", pJob->duration, "s", ",", watchdog.GetElapsedTime(), "s", ",", pJob->log);
           if(fLog) {
             logs[pJob->column].push_back(std::make_pair(pJob->log, (int)cost));
           }
@@ -1043,7 +1019,7 @@ namespace rrr {
             delete backups[column];
             backups[column] = new Ntk(*vPopulation[column]);
           }
-          if(GetRemainingTime() < 0 || nCreatedJobs >= nJobs || (nJumps && iteration - last_impr == nJumps)) {
+          if(watchdog.GetRemainingTime() < 0 || nCreatedJobs >= nJobs || (nJumps && iteration - last_impr == nJumps)) {
             vIterations[pJob->column] = pJob->iteration + 1;
             pJob = NULL; // end or wait for jump
           } else if(nHops && (iteration - last_impr) % nHops == 0) {
@@ -1075,7 +1051,7 @@ namespace rrr {
           std::cout << "column " << i << " " << costs[i] << std::endl;
         }
         std::sort(costs.begin(), costs.end());
-        Print(-1, "", "optimized", "(", nFinishedJobs, " / ", nJobs, ")", ":", costs, ",", GetElapsedTime(), "s");
+        Print(-1, "", "optimized", "(", nFinishedJobs, " / ", nJobs, ")", ":", costs, ",", watchdog.GetElapsedTime(), "s");
       }
       // sync
       double costMin = CostFunction(vPopulation[0]);
@@ -1184,7 +1160,7 @@ namespace rrr {
           vPopulation.push_back(pJob->pNtk);
           double cost = CostFunction(pJob->pNtk);
           Print(1, pJob->prefix, "finished", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost);
-          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", GetElapsedTime(), "s");
+          Print(0, "", "job", pJob->id, "(", nFinishedJobs + 1, "/", nJobs, ")", ":", "i/o", "=", pJob->pNtk->GetNumPis(), "/", pJob->pNtk->GetNumPos(), ",", "node", "=", pJob->pNtk->GetNumInts(), ",", "level", "=", pJob->pNtk->GetNumLevels(), ",", "cost", "=", cost, "(", 100 * (cost - pJob->costInitial) / pJob->costInitial, "%", ")", ",", "duration", "=", pJob->duration, "s", ",", "elapsed", "=", watchdog.GetElapsedTime(), "s");
           if(cost < costBest) {
             pNtk->Read(*(pJob->pNtk));
             costBest = cost;
@@ -1200,8 +1176,9 @@ namespace rrr {
     vPopulation.clear();
     */
     // summary
+    watchdog.Finish();
     double cost = CostFunction(pNtk);
-    double duration = GetElapsedTime();
+    double duration = watchdog.GetElapsedTime();
     Print(0, "\n", "stats summary", ":");
     for(std::string key: vStatsSummaryKeys) {
       Print(0, "\t", SW{30, true}, key, ":", SW{10}, mStatsSummary[key]);
@@ -1213,6 +1190,11 @@ namespace rrr {
     Print(0, "", "end", ":", "cost", "=", cost, "(", 100 * (cost - costStart) / costStart, "%", ")", ",", "time", "=", duration, "s");
   }
 
+  template <typename Ntk, typename Opt, typename Par>
+  void Scheduler3<Ntk, Opt, Par>::Stop() {
+    watchdog.Stop();
+  }
+
   /* }}} */
 
 }
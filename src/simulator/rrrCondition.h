@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+#include "misc/rrrUtils.h"
+
+namespace rrr {
+
+  // output-side care condition evaluated on one word of stimuli;
+  // takes PO values of the reference circuit (current one by default) and the modified circuit,
+  // and returns patterns under which the modification is observable
+  using care_condition = std::function<unsigned long long(std::vector<unsigned long long> const &, std::vector<unsigned long long> const &)>;
+
+  /* {{{ Bit-sliced counters */
+
+  // each bit position of words holds its own counter, whose i-th bit is in c[i]
+
+  inline void SlicedAdd(std::vector<unsigned long long> &c, unsigned long long x) {
+    if(!x) {
+      return;
+    }
+    for(unsigned long long &p: c) {
+      unsigned long long carry = p & x;
+      p ^= x;
+      x = carry;
+      if(!x) {
+        return;
+      }
+    }
+    c.push_back(x);
+  }
+
+  inline unsigned long long SlicedGet(std::vector<unsigned long long> const &c, int i) {
+    return i < int_size(c)? c[i]: 0;
+  }
+
+  inline unsigned long long SlicedNeq(std::vector<unsigned long long> const &a, std::vector<unsigned long long> const &b) {
+    unsigned long long r = 0;
+    for(int i = 0; i < std::max(int_size(a), int_size(b)); i++) {
+      r |= SlicedGet(a, i) ^ SlicedGet(b, i);
+    }
+    return r;
+  }
+
+  inline unsigned long long SlicedGt(std::vector<unsigned long long> const &a, std::vector<unsigned long long> const &b) {
+    unsigned long long gt = 0, eq = ~0ull;
+    for(int i = std::max(int_size(a), int_size(b)) - 1; i >= 0; i--) {
+      unsigned long long x = SlicedGet(a, i), y = SlicedGet(b, i);
+      gt |= eq & x & ~y;
+      eq &= ~(x ^ y);
+    }
+    return gt;
+  }
+
+  inline unsigned long long SlicedGtConst(std::vector<unsigned long long> const &a, int k) {
+    assert(k >= 0);
+    int nBits = int_size(a);
+    while((k >> nBits) != 0) {
+      nBits++;
+    }
+    unsigned long long gt = 0, eq = ~0ull;
+    for(int i = nBits - 1; i >= 0; i--) {
+      unsigned long long x = SlicedGet(a, i);
+      if((k >> i) & 1) {
+        eq &= x;
+      } else {
+        gt |= eq & x;
+        eq &= ~x;
+      }
+    }
+    return gt;
+  }
+
+  /* }}} */
+
+  /* {{{ Conditions */
+
+  // POs are split into nClasses groups of equal size; care if any group count changes
+  class ClassCountCondition {
+  private:
+    int nClasses;
+    std::vector<unsigned long long> c, c2;
+
+  public:
+    ClassCountCondition(int nClasses) :
+      nClasses(nClasses) {
+      assert(nClasses > 0);
+    }
+
+    unsigned long long operator()(std::vector<unsigned long long> const &v, std::vector<unsigned long long> const &v2) {
+      int n = int_size(v) / nClasses;
+      unsigned long long res = 0;
+      for(int j = 0; j < nClasses; j++) {
+        c.clear();
+        c2.clear();
+        for(int i = n * j; i < n * (j + 1); i++) {
+          SlicedAdd(c, v[i]);
+          SlicedAdd(c2, v2[i]);
+        }
+        res |= SlicedNeq(c, c2);
+      }
+      return res;
+    }
+  };
+
+  // care if the class with the largest count (first one on ties) changes
+  class ClassArgmaxCondition {
+  private:
+    int nClasses;
+    std::vector<std::vector<unsigned long long>> vc, vc2;
+    std::vector<unsigned long long> m, m2;
+
+    void Argmax(std::vector<std::vector<unsigned long long>> const &vc_, std::vector<unsigned long long> &m_) const {
+      for(int j = 0; j < nClasses; j++) {
+        m_[j] = ~0ull;
+        for(int i = 0; i < nClasses && m_[j]; i++) {
+          if(i < j) {
+            m_[j] &= SlicedGt(vc_[j], vc_[i]);
+          } else if(i > j) {
+            m_[j] &= ~SlicedGt(vc_[i], vc_[j]);
+          }
+        }
+      }
+    }
+
+  public:
+    ClassArgmaxCondition(int nClasses) :
+      nClasses(nClasses),
+      vc(nClasses),
+      vc2(nClasses),
+      m(nClasses),
+      m2(nClasses) {
+      assert(nClasses > 0);
+    }
+
+    unsigned long long operator()(std::vector<unsigned long long> const &v, std::vector<unsigned long long> const &v2) {
+      int n = int_size(v) / nClasses;
+      for(int j = 0; j < nClasses; j++) {
+        vc[j].clear();
+        vc2[j].clear();
+        for(int i = n * j; i < n * (j + 1); i++) {
+          SlicedAdd(vc[j], v[i]);
+          SlicedAdd(vc2[j], v2[i]);
+        }
+      }
+      Argmax(vc, m);
+      Argmax(vc2, m2);
+      unsigned long long res = 0;
+      for(int j = 0; j < nClasses; j++) {
+        res |= m[j] ^ m2[j];
+      }
+      return res;
+    }
+  };
+
+  // care if more than nErrors POs flip (approximate logic with Hamming-error budget);
+  // the budget bounds total error only when the reference is the original circuit
+  class HammingCondition {
+  private:
+    int nErrors;
+    std::vector<unsigned long long> c;
+
+  public:
+    HammingCondition(int nErrors) :
+      nErrors(nErrors) {
+      assert(nErrors >= 0);
+    }
+
+    unsigned long long operator()(std::vector<unsigned long long> const &v, std::vector<unsigned long long> const &v2) {
+      c.clear();
+      for(int i = 0; i < int_size(v); i++) {
+        SlicedAdd(c, v[i] ^ v2[i]);
+      }
+      return SlicedGtConst(c, nErrors);
+    }
+  };
+
+  /* }}} */
+
+}
@@ -7,6 +7,7 @@
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
 #include "extra/rrrPattern.h"
+#include "extra/rrrSlab.h"
 
 namespace rrr {
 
@@ -35,9 +36,11 @@ namespace rrr {
     // data
     bool fGenerated;
     bool fInitialized;
+    int nElemPis;
+    std::vector<word> vElems; // projection functions of inputs in index order
     std::vector<word> vFs;
     std::vector<word> vGs;
-    std::vector<std::vector<word>> vvCs;
+    Slab<word> vvCs; // carecubes of fanin edges
     std::vector<word> vValues2; // simulation with an inverter
     std::vector<word> tmp;
 
@@ -78,6 +81,9 @@ namespace rrr {
     // topology
     unsigned StartTraversal(int n = 1);
     
+    // invalidation
+    void ClearVisits(std::vector<int> const &vRoots);
+
     // simulation
     void SimulateNode(Ntk *pNtk_, std::vector<word> &v, int id) const;
     bool ResimulateNode(Ntk *pNtk_, std::vector<word> &v, int id);
@@ -261,12 +267,11 @@ namespace rrr {
     case REMOVE_FANIN:
       assert(fInitialized);
       fUpdate = true;
-      std::fill(vVisits.begin(), vVisits.end(), false);
+      ClearVisits({action.id, action.fi});
       vUpdates[action.id] = true;
       vCUpdates[action.id] = true;
       vGUpdates[action.fi] = true;
-      Copy(vvCs[action.id].size() - (action.idx + 1) * nWords, vvCs[action.id].begin() + action.idx * nWords, vvCs[action.id].begin() + (action.idx + 1) * nWords, false);
-      vvCs[action.id].resize(vvCs[action.id].size() - nWords);
+      vvCs.Erase(action.id, action.idx);
       break;
     case REMOVE_UNUSED:
       if(fInitialized) {
@@ -277,7 +282,7 @@ namespace rrr {
         }
         Clear(nWords, vFs.begin() + action.id * nWords);
         Clear(nWords, vGs.begin() + action.id * nWords);
-        vvCs[action.id].clear();
+        vvCs.Clear(action.id);
       }
       break;
     case REMOVE_BUFFER:
@@ -294,7 +299,7 @@ namespace rrr {
         }
         Clear(nWords, vFs.begin() + action.id * nWords);
         Clear(nWords, vGs.begin() + action.id * nWords);
-        vvCs[action.id].clear();
+        vvCs.Clear(action.id);
       }
       break;
     case REMOVE_CONST:
@@ -312,28 +317,27 @@ namespace rrr {
       }
       Clear(nWords, vFs.begin() + action.id * nWords);
       Clear(nWords, vGs.begin() + action.id * nWords);
-      vvCs[action.id].clear();
+      vvCs.Clear(action.id);
       break;
     case ADD_FANIN:
       assert(fInitialized);
       fUpdate = true;
-      std::fill(vVisits.begin(), vVisits.end(), false);
+      ClearVisits({action.id, action.fi});
       vUpdates[action.id] = true;
       vCUpdates[action.id] = true;
-      vvCs[action.id].insert(vvCs[action.id].begin() + action.idx * nWords, nWords, 0);
+      vvCs.Insert(action.id, action.idx);
       break;
     case TRIVIAL_COLLAPSE:
       if(fInitialized) {
         if(vGUpdates[action.fi] || vCUpdates[action.fi]) {
           vCUpdates[action.id] = true;
         }
-        itr it = vvCs[action.id].begin() + action.idx * nWords;
-        it = vvCs[action.id].erase(it, it + nWords);
-        for(int idx: action.vIndices) {
-          it = vvCs[action.id].insert(it,  vvCs[action.fi].begin() + idx * nWords, vvCs[action.fi].begin() + (idx + 1) * nWords);
-          it += nWords;
+        vvCs.Erase(action.id, action.idx);
+        vvCs.Insert(action.id, action.idx, int_size(action.vIndices));
+        for(int i = 0; i < int_size(action.vIndices); i++) {
+          Copy(nWords, vvCs.Get(action.id, action.idx + i), vvCs.Get(action.fi, action.vIndices[i]), false);
         }
-        vvCs[action.fi].clear();
+        vvCs.Clear(action.fi);
         Clear(nWords, vFs.begin() + action.fi * nWords);
         Clear(nWords, vGs.begin() + action.fi * nWords);
       }
@@ -342,7 +346,7 @@ namespace rrr {
       if(fInitialized) {
         vFs.resize(pNtk->GetNumNodes() * nWords);
         vGs.resize(pNtk->GetNumNodes() * nWords);
-        vvCs.resize(pNtk->GetNumNodes());
+        vvCs.Allocate(pNtk->GetNumNodes());
         vUpdates.resize(pNtk->GetNumNodes());
         vGUpdates.resize(pNtk->GetNumNodes());
         vCUpdates.resize(pNtk->GetNumNodes());
@@ -350,10 +354,10 @@ namespace rrr {
         vWasReconvergent.resize(pNtk->GetNumNodes());
         SimulateNode(pNtk, vFs, action.fi);
         // time of this simulation is not measured for simplicity sake
-        itr it = vvCs[action.id].begin() + action.idx * nWords;
-        vvCs[action.fi].insert(vvCs[action.fi].begin(), it, vvCs[action.id].end());
-        vvCs[action.id].erase(it, vvCs[action.id].end());
-        assert(vvCs[action.id].size() == action.idx * nWords);
+        assert(vvCs.Size(action.fi) == 0);
+        vvCs.Resize(action.fi, vvCs.Size(action.id) - action.idx);
+        Copy(vvCs.Size(action.fi) * nWords, vvCs.Get(action.fi, 0), vvCs.Get(action.id, action.idx), false);
+        vvCs.Resize(action.id, action.idx);
         if(!vGUpdates[action.id] && !vCUpdates[action.id]) {
           // recompute here only when updates are unlikely to happen
           if(IsZero(nWords, vGs.begin() + action.id * nWords, true)) {
@@ -371,8 +375,8 @@ namespace rrr {
           // otherwise mark the node for future update
           vCUpdates[action.id] = true;
         }
-        vvCs[action.id].resize((action.idx + 1) * nWords);
-        Copy(nWords, vvCs[action.id].begin() + action.idx * nWords, vGs.begin() + action.fi * nWords, false);
+        vvCs.Resize(action.id, action.idx + 1);
+        Copy(nWords, vvCs.Get(action.id, action.idx), vGs.begin() + action.fi * nWords, false);
         vUpdates[action.fi] = false;
         vGUpdates[action.fi] = false;
         vCUpdates[action.fi] = false;
@@ -382,12 +386,9 @@ namespace rrr {
       break;
     case SORT_FANINS:
       if(fInitialized) {
-        std::vector<word> vCs = vvCs[action.id];
-        vvCs[action.id].clear();
-        for(int index: action.vIndices) {
-          for(int i = 0; i < nWords; i++) {
-            vvCs[action.id].push_back(vCs[index * nWords + i]);
-          }
+        std::vector<word> vCs(vvCs.Get(action.id, 0), vvCs.Get(action.id, vvCs.Size(action.id)));
+        for(int i = 0; i < int_size(action.vIndices); i++) {
+          Copy(nWords, vvCs.Get(action.id, i), vCs.begin() + action.vIndices[i] * nWords, false);
         }
       }
       break;
@@ -444,6 +445,27 @@ namespace rrr {
     return iTrav - n + 1;
   }
 
+  /* }}} */
+
+  /* {{{ Invalidation */
+
+  template <typename Ntk>
+  void DcSimulator<Ntk>::ClearVisits(std::vector<int> const &vRoots) {
+    // careset of reconvergent node depends only on its TFO and side inputs, so nodes outside TFI of roots keep theirs
+    StartTraversal();
+    for(int id: vRoots) {
+      vTrav[id] = iTrav;
+    }
+    pNtk->ForEachIntReverse([&](int id) {
+      if(vTrav[id] == iTrav) {
+        vVisits[id] = false;
+        pNtk->ForEachFanin(id, [&](int fi) {
+          vTrav[fi] = iTrav;
+        });
+      }
+    });
+  }
+
   /* }}} */
   
   /* {{{ Simulation */
@@ -541,17 +563,23 @@ namespace rrr {
     if(nVerbose) {
       std::cout << "resimulating" << std::endl;
     }
+    std::vector<int> vChanged; // nodes with new functions and their fanouts
     pNtk->ForEachInt([&](int id) {
       if(vUpdates[id]) {
         if(ResimulateNode(pNtk, vFs, id)) {
+          vChanged.push_back(id);
           pNtk->ForEachFanout(id, false, [&](int fo) {
             vUpdates[fo] = true;
             vCUpdates[fo] = true;
+            vChanged.push_back(fo);
           });
         }
         vUpdates[id] = false;
       }
     });
+    if(!vChanged.empty()) {
+      ClearVisits(vChanged);
+    }
     /*
     int index = 0;
     pNtk->ForEachPoDriver([&](int fi, bool c){
@@ -571,30 +599,37 @@ namespace rrr {
     if(nVerbose) {
       std::cout << "generating exhaustive stimuli" << std::endl;
     }
-    assert(pNtk->GetNumPis() < 30);
-    if(pNtk->GetNumPis() <= 6) {
-      nWords = 1;
-    } else {
-      nWords = 1 << (pNtk->GetNumPis() - 6);
-    }
-    vFs.resize(pNtk->GetNumNodes() * nWords);
-    pNtk->ForEachPiIdx([&](int index, int id) {
-      if(index < 6) {
-        itr it = vFs.begin() + id * nWords;
-        for(int i = 0; i < nWords; i++, it++) {
-          *it = basepats[index];
-        }
+    if(pNtk->GetNumPis() != nElemPis) {
+      // projections are kept for following networks with same number of inputs
+      nElemPis = pNtk->GetNumPis();
+      assert(nElemPis < 30);
+      if(nElemPis <= 6) {
+        nWords = 1;
       } else {
-        itr it = vFs.begin() + id * nWords;
-        for(int i = 0; i < nWords;) {
-          for(int j = 0; j < (1 << (index - 6)); i++, j++, it++) {
-            *it = 0;
+        nWords = 1 << (nElemPis - 6);
+      }
+      vElems.resize(nElemPis * nWords);
+      for(int index = 0; index < nElemPis; index++) {
+        itr it = vElems.begin() + index * nWords;
+        if(index < 6) {
+          for(int i = 0; i < nWords; i++, it++) {
+            *it = basepats[index];
           }
-          for(int j = 0; j < (1 << (index - 6)); i++, j++, it++) {
-            *it = 0xffffffffffffffffull;
+        } else {
+          for(int i = 0; i < nWords;) {
+            for(int j = 0; j < (1 << (index - 6)); i++, j++, it++) {
+              *it = 0;
+            }
+            for(int j = 0; j < (1 << (index - 6)); i++, j++, it++) {
+              *it = 0xffffffffffffffffull;
+            }
           }
         }
       }
+    }
+    vFs.resize(pNtk->GetNumNodes() * nWords);
+    pNtk->ForEachPiIdx([&](int index, int id) {
+      Copy(nWords, vFs.begin() + id * nWords, vElems.begin() + index * nWords, false);
       if(nVerbose) {
         std::cout << "node " << std::setw(3) << id << ": ";
         Print(nWords, vFs.begin() + id * nWords);
@@ -688,7 +723,7 @@ namespace rrr {
     }
     Fill(nWords, tmp.begin());
     pNtk->ForEachFanoutRidx(id, true, [&](int fo, int idx) {
-      And(nWords, tmp.begin(), tmp.begin(), vvCs[fo].begin() + idx * nWords, false, false);
+      And(nWords, tmp.begin(), tmp.begin(), vvCs.Get(fo, idx), false, false);
     });
     if(IsEq(nWords, vGs.begin() + id * nWords, tmp.begin(), false)) {
       return false;
@@ -700,11 +735,11 @@ namespace rrr {
   template <typename Ntk>
   inline void DcSimulator<Ntk>::ComputeC(int id) {
     int nFanins = pNtk->GetNumFanins(id);
-    assert(vvCs[id].size() == nFanins * nWords);
+    assert(vvCs.Size(id) == nFanins);
     if(IsZero(nWords, vGs.begin() + id * nWords, true)) {
       for(int idx = 0; idx < nFanins; idx++) {
-        if(!IsZero(nWords, vvCs[id].begin() + idx * nWords, true)) {
-          Fill(nWords, vvCs[id].begin() + idx * nWords);
+        if(!IsZero(nWords, vvCs.Get(id, idx), true)) {
+          Fill(nWords, vvCs.Get(id, idx));
           int fi = pNtk->GetFanin(id, idx);
           vGUpdates[fi] = true;
         }
@@ -721,8 +756,8 @@ namespace rrr {
         }
       }
       Or(nWords, tmp.begin(), tmp.begin(), vGs.begin() + id * nWords, true, false);
-      if(!IsEq(nWords, vvCs[id].begin() + idx * nWords, tmp.begin(), false)) {
-        Copy(nWords, vvCs[id].begin() + idx * nWords, tmp.begin(), false);
+      if(!IsEq(nWords, vvCs.Get(id, idx), tmp.begin(), false)) {
+        Copy(nWords, vvCs.Get(id, idx), tmp.begin(), false);
         int fi = pNtk->GetFanin(id, idx);
         vGUpdates[fi] = true;
       }
@@ -799,10 +834,8 @@ namespace rrr {
     vFs.resize(pNtk->GetNumNodes() * nWords);
     vGs.clear();
     vGs.resize(pNtk->GetNumNodes() * nWords);
-    vvCs.resize(pNtk->GetNumNodes());
-    for(int i = 0; i < pNtk->GetNumNodes(); i++) {
-      vvCs[i].clear();
-    }
+    vvCs.Allocate(pNtk->GetNumNodes());
+    vvCs.Reset(nWords);
     Simulate();
     vUpdates.clear();
     vUpdates.resize(pNtk->GetNumNodes());
@@ -815,10 +848,10 @@ namespace rrr {
     vWasReconvergent.clear();
     vWasReconvergent.resize(pNtk->GetNumNodes());
     pNtk->ForEachInt([&](int id) {
-      vvCs[id].resize(pNtk->GetNumFanins(id) * nWords);
+      vvCs.Resize(id, pNtk->GetNumFanins(id));
     });
     pNtk->ForEachPo([&](int id) {
-      vvCs[id].resize(nWords);
+      vvCs.Resize(id, 1);
     });
     // TODO: maybe reset updates and others as well
     fInitialized = true;
@@ -870,6 +903,7 @@ namespace rrr {
     fSave(false),
     fGenerated(false),
     fInitialized(false),
+    nElemPis(-1),
     iTrav(0),
     fUpdate(false) {
     ResetSummary();
@@ -883,6 +917,7 @@ namespace rrr {
     fSave(pPar->fSave),
     fGenerated(false),
     fInitialized(false),
+    nElemPis(-1),
     iTrav(0),
     fUpdate(false) {
     tmp.resize(nWords);
@@ -918,7 +953,7 @@ namespace rrr {
     case AND: {
       int fi = pNtk->GetFanin(id, idx);
       bool c = pNtk->GetCompl(id, idx);
-      Or(nWords, tmp.begin(), vFs.begin() + fi * nWords, vvCs[id].begin() + idx * nWords, c, false);
+      Or(nWords, tmp.begin(), vFs.begin() + fi * nWords, vvCs.Get(id, idx), c, false);
       return IsZero(nWords, tmp.begin(), true);
     }
     default:
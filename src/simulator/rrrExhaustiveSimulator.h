@@ -36,11 +36,18 @@ namespace rrr {
     bool fGenerated;
     bool fInitialized;
     int target; // node for which the careset has been computed
-    std::vector<word> vValues;
-    std::vector<word> vValues2; // simulation with an inverter
+    std::vector<word> vValues; // values of all nodes, kept as queries may read any node
+    std::vector<word> vValues2; // buffer pool for simulation with an inverter
     std::vector<word> care; // careset
     std::vector<word> tmp;
 
+    // buffer scheduling for careset computation
+    int nBufs; // number of buffers allocated in pool
+    std::vector<int> vTfo; // TFO of target in topological order
+    std::vector<int> vBufs; // buffer index of each node in TFO
+    std::vector<int> vLastUses; // position in TFO where each node is used for the last time
+    std::vector<int> vFreeBufs;
+
     // backups
     std::vector<ExhaustiveSimulator> vBackups;
 
@@ -84,6 +91,7 @@ namespace rrr {
     void GenerateExhaustiveStimuli();
 
     // careset computation
+    int  AllocateBuffer();
     void ComputeCare(int id);
 
     // preparation
@@ -516,6 +524,19 @@ namespace rrr {
   /* }}} */
 
   /* {{{ Careset computation */
+
+  template <typename Ntk>
+  inline int ExhaustiveSimulator<Ntk>::AllocateBuffer() {
+    if(!vFreeBufs.empty()) {
+      int i = vFreeBufs.back();
+      vFreeBufs.pop_back();
+      return i;
+    }
+    if((nBufs + 1) * nWords > int_size(vValues2)) {
+      vValues2.resize((nBufs + 1) * nWords);
+    }
+    return nBufs++;
+  }
   
   template <typename Ntk>
   void ExhaustiveSimulator<Ntk>::ComputeCare(int id) {
@@ -545,13 +566,40 @@ namespace rrr {
       durationCare += Duration(timeStart, GetCurrentTime());
       return;
     }
-    vValues2.resize(nWords * pNtk->GetNumNodes());
+    // schedule TFO and find the last use of each node
     StartTraversal();
-    Copy(nWords, vValues2.begin() + target * nWords, vValues.begin() + target * nWords, true);
     vTrav[target] = iTrav;
+    vTfo.clear();
     pNtk->ForEachTfo(target, false, [&](int id) {
+      vTfo.push_back(id);
+      vTrav[id] = iTrav;
+    });
+    vBufs.resize(pNtk->GetNumNodes());
+    vLastUses.resize(pNtk->GetNumNodes());
+    vLastUses[target] = -1;
+    for(int i = 0; i < int_size(vTfo); i++) {
+      vLastUses[vTfo[i]] = -1;
+      pNtk->ForEachFanin(vTfo[i], [&](int fi) {
+        if(vTrav[fi] == iTrav) {
+          vLastUses[fi] = i;
+        }
+      });
+    }
+    pNtk->ForEachPoDriver([&](int fi) {
+      if(vTrav[fi] == iTrav) {
+        vLastUses[fi] = int_size(vTfo); // kept until careset is computed
+      }
+    });
+    // simulate TFO recycling buffers of nodes that are no longer used
+    nBufs = 0;
+    vFreeBufs.clear();
+    vBufs[target] = AllocateBuffer();
+    Copy(nWords, vValues2.begin() + vBufs[target] * nWords, vValues.begin() + target * nWords, true);
+    for(int i = 0; i < int_size(vTfo); i++) {
+      int id = vTfo[i];
+      vBufs[id] = AllocateBuffer();
       itr x = vValues2.end();
-      itr y = vValues2.begin() + id * nWords;
+      itr y = vValues2.begin() + vBufs[id] * nWords;
       bool cx = false;
       switch(pNtk->GetNodeType(id)) {
       case AND:
@@ -560,14 +608,14 @@ namespace rrr {
             if(vTrav[fi] != iTrav) {
               x = vValues.begin() + fi * nWords;
             } else {
-              x = vValues2.begin() + fi * nWords;
+              x = vValues2.begin() + vBufs[fi] * nWords;
             }
             cx = c;
           } else {
             if(vTrav[fi] != iTrav) {
               And(nWords, y, x, vValues.begin() + fi * nWords, cx, c);
             } else {
-              And(nWords, y, x, vValues2.begin() + fi * nWords, cx, c);
+              And(nWords, y, x, vValues2.begin() + vBufs[fi] * nWords, cx, c);
             }
             x = y;
             cx = false;
@@ -582,19 +630,24 @@ namespace rrr {
       default:
         assert(0);
       }
-      vTrav[id] = iTrav;
       if(nVerbose) {
         std::cout << "node " << std::setw(3) << id << ": ";
-        Print(nWords, vValues2.begin() + id * nWords);
+        Print(nWords, y);
         std::cout << std::endl;
       }
-    });
+      pNtk->ForEachFanin(id, [&](int fi) {
+        if(vTrav[fi] == iTrav && vLastUses[fi] == i) {
+          vFreeBufs.push_back(vBufs[fi]);
+        }
+      });
+    }
     Clear(nWords, care.begin());
     pNtk->ForEachPoDriver([&](int fi) {
       assert(fi != target);
       if(vTrav[fi] == iTrav) { // skip unaffected POs
+        citr x = vValues2.begin() + vBufs[fi] * nWords;
         for(int i = 0; i < nWords; i++) {
-          care[i] = care[i] | (vValues[fi * nWords + i] ^ vValues2[fi * nWords + i]);
+          care[i] = care[i] | (vValues[fi * nWords + i] ^ x[i]);
         }
       }
     });
@@ -679,6 +732,7 @@ namespace rrr {
     fGenerated(false),
     fInitialized(false),
     target(-1),
+    nBufs(0),
     iTrav(0),
     fUpdate(false) {
     ResetSummary();
@@ -693,6 +747,7 @@ namespace rrr {
     fGenerated(false),
     fInitialized(false),
     target(-1),
+    nBufs(0),
     iTrav(0),
     fUpdate(false) {
     care.resize(nWords);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <random>
 #include <bitset>
+#include <memory>
 
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
@@ -16,7 +17,10 @@ namespace rrr {
     using word = unsigned long long;
     using itr = std::vector<word>::iterator;
     using citr = std::vector<word>::const_iterator;
+    using page = std::shared_ptr<std::vector<word> const>;
     static constexpr bool fKeepStimula = true;
+    static constexpr int nPageWords = 4096; // target number of words per snapshot page
+    static constexpr int nSigBits = 10; // max number of patterns indexed in signature buckets
     static constexpr word one = 0xffffffffffffffff;
     static constexpr word basepats[] = {0xaaaaaaaaaaaaaaaaull,
                                         0xccccccccccccccccull,
@@ -59,6 +63,18 @@ namespace rrr {
     // backups
     std::vector<Simulator> vBackups;
 
+    // snapshot pages (shared with backups until written)
+    int nPageNodes;
+    std::vector<page> vPages;
+    std::vector<bool> vDirty;
+
+    // signature index (nodes bucketed by values under indexed patterns)
+    bool fSigs; // up to date
+    std::vector<int> vSigPats; // indexed patterns, chosen from care
+    std::vector<std::vector<int>> vvSigBuckets;
+    std::vector<int> vSigKeys;
+    std::vector<int> vSigPos;
+
     // stats
     int nCex;
     int nDiscarded;
@@ -102,6 +118,19 @@ namespace rrr {
     // preparation
     void Initialize();
 
+    // snapshot pages
+    void ResetPages();
+    void MarkDirty(int id);
+    void SavePages();
+    void LoadPages(std::vector<page> const &vPages_, int nPageNodes_);
+    word GetPageWord(int id, int offset) const;
+
+    // signature index
+    int GetSigKey(citr x) const;
+    void ChooseSigPats();
+    void ResetSigs();
+    void UpdateSig(int id);
+
     // save & load
     void Save(int slot);
     void Load(int slot);
@@ -117,6 +146,9 @@ namespace rrr {
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
 
+    // candidates
+    void GetCandidates(int id, std::vector<int> &vCands, bool fCompl);
+
     // cex
     void AddCex(std::vector<VarValue> const &vCex);
 
@@ -272,6 +304,8 @@ namespace rrr {
       if(fInitialized) {
         vValues.resize(nWords * pNtk->GetNumNodes());
         SimulateNode(vValues, action.fi);
+        MarkDirty(action.fi);
+        UpdateSig(action.fi);
         // time of this simulation is not measured for simplicity sake
       }
       break;
@@ -417,6 +451,7 @@ namespace rrr {
     if(nVerbose) {
       std::cout << "simulating" << std::endl;
     }
+    fSigs = false;
     pNtk->ForEachInt([&](int id) {
       SimulateNode(vValues, id);
       if(nVerbose) {
@@ -436,6 +471,10 @@ namespace rrr {
     }
     pNtk->ForEachTfosUpdate(sUpdates, false, [&](int fo) {
       bool fUpdated = ResimulateNode(vValues, fo);
+      if(fUpdated) {
+        MarkDirty(fo);
+        UpdateSig(fo);
+      }
       if(nVerbose) {
         std::cout << "node " << std::setw(3) << fo << ": ";
         Print(nWords, vValues.begin() + fo * nWords);
@@ -462,8 +501,15 @@ namespace rrr {
     if(nVerbose) {
       std::cout << "simulating word " << offset << std::endl;
     }
+    for(int pat: vSigPats) {
+      if(pat >> 6 == offset) {
+        fSigs = false;
+        break;
+      }
+    }
     pNtk->ForEachInt([&](int id) {
       SimulateOneWordNode(vValues, id, offset);
+      MarkDirty(id);
       if(nVerbose) {
         std::cout << "node " << std::setw(3) << id << ": ";
         Print(1, vValues.begin() + id * nWords + offset);
@@ -666,6 +712,7 @@ namespace rrr {
       }
       care.resize(nWords);
       tmp.resize(nWords);
+      vSigPats.clear();
       iPivot = 0;
       vAssignedStimuli.clear();
       vAssignedStimuli.resize(nWords * pNtk->GetNumPis());
@@ -685,11 +732,146 @@ namespace rrr {
     fUpdate = false;
     sUpdates.clear();
     Simulate();
+    ResetPages();
     fInitialized = true;
   }
 
   /* }}} */
 
+  /* {{{ Snapshot pages */
+
+  template <typename Ntk>
+  void Simulator<Ntk>::ResetPages() {
+    // a page holds values of consecutive nodes, so values of a node never span two pages
+    nPageNodes = std::max(1, nPageWords / nWords);
+    vPages.clear();
+    vDirty.clear();
+  }
+
+  template <typename Ntk>
+  inline void Simulator<Ntk>::MarkDirty(int id) {
+    int i = id / nPageNodes;
+    if(i < int_size(vDirty)) {
+      vDirty[i] = true;
+    }
+  }
+
+  template <typename Ntk>
+  void Simulator<Ntk>::SavePages() {
+    int nPages = (int_size(vValues) / nWords + nPageNodes - 1) / nPageNodes;
+    vPages.resize(nPages);
+    vDirty.resize(nPages, true);
+    for(int i = 0; i < nPages; i++) {
+      citr begin = vValues.begin() + i * nPageNodes * nWords;
+      citr end = (i == nPages - 1)? vValues.cend(): begin + nPageNodes * nWords;
+      if(!vDirty[i] && vPages[i] && int_distance(begin, end) == int_size(*vPages[i])) {
+        // unchanged since last save or load, so share it
+        continue;
+      }
+      vPages[i] = std::make_shared<std::vector<word> const>(begin, end);
+      vDirty[i] = false;
+    }
+  }
+
+  template <typename Ntk>
+  void Simulator<Ntk>::LoadPages(std::vector<page> const &vPages_, int nPageNodes_) {
+    std::vector<word>::size_type size = 0;
+    for(page const &p: vPages_) {
+      size += p->size();
+    }
+    vValues.resize(size);
+    itr it = vValues.begin();
+    for(int i = 0; i < int_size(vPages_); i++) {
+      // identical pages are the same object, which has not been modified if clean
+      if(i >= int_size(vPages) || vDirty[i] || vPages[i] != vPages_[i]) {
+        std::copy(vPages_[i]->begin(), vPages_[i]->end(), it);
+      }
+      it += vPages_[i]->size();
+    }
+    nPageNodes = nPageNodes_;
+    vPages = vPages_;
+    fSigs = false;
+    vDirty.clear();
+    vDirty.resize(vPages.size());
+  }
+
+  template <typename Ntk>
+  inline typename Simulator<Ntk>::word Simulator<Ntk>::GetPageWord(int id, int offset) const {
+    return (*vPages[id / nPageNodes])[(id % nPageNodes) * nWords + offset];
+  }
+
+  /* }}} */
+
+  /* {{{ Signature index */
+
+  template <typename Ntk>
+  inline int Simulator<Ntk>::GetSigKey(citr x) const {
+    int key = 0;
+    for(int i = 0; i < int_size(vSigPats); i++) {
+      key |= ((x[vSigPats[i] >> 6] >> (vSigPats[i] & 63)) & 1) << i;
+    }
+    return key;
+  }
+
+  template <typename Ntk>
+  void Simulator<Ntk>::ChooseSigPats() {
+    // patterns outside care constrain no candidate, so take first ones in care
+    vSigPats.clear();
+    for(int i = 0; i < nWords && int_size(vSigPats) < nSigBits; i++) {
+      for(int j = 0; j < 64 && int_size(vSigPats) < nSigBits; j++) {
+        if((care[i] >> j) & 1) {
+          vSigPats.push_back(i * 64 + j);
+        }
+      }
+    }
+    fSigs = false;
+  }
+
+  template <typename Ntk>
+  void Simulator<Ntk>::ResetSigs() {
+    vvSigBuckets.resize(1 << int_size(vSigPats));
+    for(std::vector<int> &vBucket: vvSigBuckets) {
+      vBucket.clear();
+    }
+    vSigKeys.clear();
+    vSigKeys.resize(pNtk->GetNumNodes(), -1);
+    vSigPos.resize(pNtk->GetNumNodes());
+    fSigs = true;
+    pNtk->ForEachPi([&](int id) {
+      UpdateSig(id);
+    });
+    pNtk->ForEachInt([&](int id) {
+      UpdateSig(id);
+    });
+  }
+
+  template <typename Ntk>
+  inline void Simulator<Ntk>::UpdateSig(int id) {
+    if(!fSigs) {
+      // will be rebuilt on demand
+      return;
+    }
+    if(id >= int_size(vSigKeys)) {
+      vSigKeys.resize(pNtk->GetNumNodes(), -1);
+      vSigPos.resize(pNtk->GetNumNodes());
+    }
+    int key = GetSigKey(vValues.begin() + id * nWords);
+    if(vSigKeys[id] == key) {
+      return;
+    }
+    if(vSigKeys[id] != -1) {
+      std::vector<int> &vBucket = vvSigBuckets[vSigKeys[id]];
+      vBucket[vSigPos[id]] = vBucket.back();
+      vSigPos[vBucket.back()] = vSigPos[id];
+      vBucket.pop_back();
+    }
+    vSigKeys[id] = key;
+    vSigPos[id] = int_size(vvSigBuckets[key]);
+    vvSigBuckets[key].push_back(id);
+  }
+
+  /* }}} */
+
   /* {{{ Save & load */
 
   template <typename Ntk>
@@ -719,7 +901,9 @@ namespace rrr {
       Resimulate();
       sUpdates.clear();
     }
-    vBackups[slot].vValues = vValues;
+    SavePages();
+    vBackups[slot].nPageNodes = nPageNodes;
+    vBackups[slot].vPages = vPages;
     vBackups[slot].iPivot = iPivot;
     vBackups[slot].vAssignedStimuli = vAssignedStimuli;
     target = vBackups[slot].target; // assigned to -1 when careset needs updating
@@ -745,9 +929,9 @@ namespace rrr {
     if(!fKeepStimula) {
       nWords  = vBackups[slot].nWords;
       target  = vBackups[slot].target;
-      vValues = vBackups[slot].vValues;
       care    = vBackups[slot].care;
       iPivot  = vBackups[slot].iPivot;
+      LoadPages(vBackups[slot].vPages, vBackups[slot].nPageNodes);
       vAssignedStimuli = vBackups[slot].vAssignedStimuli;
       nDiscarded += nCex - vBackups[slot].nCex;
       nCex = vBackups[slot].nCex;
@@ -760,7 +944,7 @@ namespace rrr {
       for(int i = 0; i < vBackups[slot].nWords; i++) {
         bool fDifferent = false;
         pNtk->ForEachPi([&](int id) {
-          if(vValues[id * vBackups[slot].nWords + i] != vValues[id * nWords + i]) {
+          if(vBackups[slot].GetPageWord(id, i) != vValues[id * nWords + i]) {
             fDifferent = true;
           }
         });
@@ -771,8 +955,8 @@ namespace rrr {
       if(nWords == vBackups[slot].nWords) {
         if(vOffsets.empty()) {
           target  = vBackups[slot].target;
-          vValues = vBackups[slot].vValues;
           care    = vBackups[slot].care;
+          LoadPages(vBackups[slot].vPages, vBackups[slot].nPageNodes);
         } else {
           target = -1;
           std::vector<std::vector<word>> vInputStimuli(pNtk->GetNumPis());
@@ -780,9 +964,10 @@ namespace rrr {
             vInputStimuli[idx].resize(nWords);
             Copy(nWords, vInputStimuli[idx].begin(), vValues.begin() + id * nWords, false);
           });
-          vValues = vBackups[slot].vValues;
+          LoadPages(vBackups[slot].vPages, vBackups[slot].nPageNodes);
           pNtk->ForEachPiIdx([&](int idx, int id) {
             Copy(nWords, vValues.begin() + id * nWords, vInputStimuli[idx].begin(), false);
+            MarkDirty(id);
           });
           for(int i: vOffsets) {
             SimulateOneWord(i);
@@ -811,7 +996,9 @@ namespace rrr {
     target(-1),
     iTrav(0),
     iPivot(0),
-    fUpdate(false) {
+    fUpdate(false),
+    nPageNodes(1),
+    fSigs(false) {
     ResetSummary();
   }
   
@@ -827,7 +1014,9 @@ namespace rrr {
     target(-1),
     iTrav(0),
     iPivot(0),
-    fUpdate(false) {
+    fUpdate(false),
+    nPageNodes(1),
+    fSigs(false) {
     ResetSummary();
   }
 
@@ -930,6 +1119,71 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Candidates */
+
+  template <typename Ntk>
+  void Simulator<Ntk>::GetCandidates(int id, std::vector<int> &vCands, bool fCompl) {
+    // collect edges (fi << 1 | c) that pass CheckFeasibility, complemented ones only if fCompl
+    if(!fInitialized) {
+      Initialize();
+    }
+    ComputeCare(id);
+    int nSigPatsInCare = 0;
+    for(int pat: vSigPats) {
+      nSigPatsInCare += (care[pat >> 6] >> (pat & 63)) & 1;
+    }
+    if(vSigPats.empty() || 2 * nSigPatsInCare < int_size(vSigPats)) {
+      ChooseSigPats();
+    }
+    if(!fSigs) {
+      ResetSigs();
+    }
+    vCands.clear();
+    assert(pNtk->GetNodeType(id) == AND);
+    // on-set under care
+    Copy(nWords, tmp.begin(), care.begin(), false);
+    pNtk->ForEachFanin(id, [&](int fi, bool c) {
+      And(nWords, tmp.begin(), tmp.begin(), vValues.begin() + fi * nWords, false, c);
+    });
+    int mask = (1 << int_size(vSigPats)) - 1;
+    int m = GetSigKey(tmp.begin());
+    auto Check = [&](int fi, bool c) {
+      citr x = vValues.begin() + fi * nWords;
+      for(int i = 0; i < nWords; i++) {
+        if(tmp[i] & (c? x[i]: ~x[i])) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto Collect = [&](int key, bool c) {
+      for(int fi: vvSigBuckets[key]) {
+        if(fi == id || (!pNtk->IsInt(fi) && !pNtk->IsPi(fi))) {
+          continue;
+        }
+        if(Check(fi, c)) {
+          vCands.push_back(fi << 1 | (int)c);
+        }
+      }
+    };
+    // positive fanin must be one wherever on-set is, so keys are supersets of m
+    for(int key = m; key <= mask; key = (key + 1) | m) {
+      Collect(key, false);
+    }
+    if(!fCompl) {
+      return;
+    }
+    // negative fanin must be zero wherever on-set is, so keys are disjoint with m
+    for(int key = ~m & mask; ; key = (key - 1) & ~m & mask) {
+      Collect(key, true);
+      if(key == 0) {
+        break;
+      }
+    }
+  }
+
+  /* }}} */
+
   /* {{{ Cex */
 
   template <typename Ntk>
@@ -1027,6 +1281,7 @@ namespace rrr {
         assert(vCex[idx] == rrrFALSE);
         vValues[id * nWords + iWord] &= ~mask;
       }
+      MarkDirty(id);
       vAssignedStimuli[idx * nWords + iWord] |= mask;
       if(nVerbose) {
         std::cout << "node " << std::setw(3) << id << ": ";
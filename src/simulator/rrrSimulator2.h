@@ -7,6 +7,7 @@
 #include "misc/rrrParameter.h"
 #include "misc/rrrUtils.h"
 #include "extra/rrrPattern.h"
+#include "simulator/rrrCondition.h"
 
 namespace rrr {
 
@@ -35,7 +36,8 @@ namespace rrr {
     int nStimuli;
     bool fExSim;
     bool fUseCustomCondition = false;
-    std::function<word(std::vector<word> const &, std::vector<word> const &)> CustomCondition;
+    care_condition CustomCondition;
+    bool fCustomOriginal = false; // custom condition compares with original PO values instead of current ones
     bool fUseOriginalPoValues = false;
     // TODO: support last_mask
 
@@ -50,7 +52,7 @@ namespace rrr {
     //std::vector<std::vector<word>> vPoValues;
     std::vector<word> vValuesCond;
     std::vector<word> vValuesCond2;
-    std::vector<word> vOriginalPoValues;
+    std::vector<word> vOriginalPoValues; // taken once after network is assigned
 
     // marks
     unsigned iTrav;
@@ -123,6 +125,9 @@ namespace rrr {
     bool CheckRedundancy(int id, int idx);
     bool CheckFeasibility(int id, int fi, bool c);
 
+    // custom condition
+    void SetCustomCondition(care_condition Condition, bool fOriginal = false);
+
     // sdc
     std::vector<word> ComputeSdc(std::vector<int> const &ids);
 
@@ -845,21 +850,28 @@ namespace rrr {
       });
     } else if(fUseCustomCondition) {
       std::vector<word> vPoValues(pNtk->GetNumPos()), vPoValues2(pNtk->GetNumPos());
+      std::vector<citr> vPoItrs, vPoItrs2;
+      std::vector<word> vPoMasks;
+      pNtk->ForEachPoDriver([&](int fi, bool c) {
+        vPoItrs.push_back(vValues.begin() + fi * nStimuli);
+        if(vTrav[fi] == iTrav) {
+          vPoItrs2.push_back(vValues2.begin() + fi * nStimuli);
+        } else {
+          vPoItrs2.push_back(vValues.begin() + fi * nStimuli);
+        }
+        vPoMasks.push_back(c? one: 0);
+      });
+      if(fCustomOriginal) {
+        // original values are stored with complements applied
+        for(int index = 0; index < int_size(vPoItrs); index++) {
+          vPoItrs[index] = vOriginalPoValues.begin() + index * nStimuli;
+        }
+      }
       for(int i = 0; i < nStimuli; i++) {
-        int index = 0;
-        pNtk->ForEachPoDriver([&](int fi, bool c) {
-          vPoValues[index] = vValues[fi * nStimuli + i];
-          if(vTrav[fi] == iTrav) {
-            vPoValues2[index] = vValues2[fi * nStimuli + i];
-          } else {
-            vPoValues2[index] = vValues[fi * nStimuli + i];
-          }
-          if(c) {
-            vPoValues[index] ^= ~0ull;
-            vPoValues2[index] ^= ~0ull;
-          }
-          index++;
-        });
+        for(int index = 0; index < int_size(vPoMasks); index++) {
+          vPoValues[index] = vPoItrs[index][i] ^ (fCustomOriginal? 0: vPoMasks[index]);
+          vPoValues2[index] = vPoItrs2[index][i] ^ vPoMasks[index];
+        }
         care[i] = CustomCondition(vPoValues, vPoValues2);
       }
     } else if(fUseOriginalPoValues) {
@@ -964,7 +976,7 @@ namespace rrr {
       }
     }
     Simulate();
-    if(fUseOriginalPoValues) {
+    if((fUseOriginalPoValues || fCustomOriginal) && vOriginalPoValues.empty()) {
       vOriginalPoValues.resize(nStimuli * pNtk->GetNumPos());
       int index = 0;
       pNtk->ForEachPoDriver([&](int fi, bool c) {
@@ -1011,23 +1023,21 @@ namespace rrr {
     care.resize(nWords);
     tmp.resize(nWords);
     ResetSummary();
-    CustomCondition = [&](std::vector<word> const &v, std::vector<word> const &v2) {
-      int n = pNtk->GetNumPos() / 10;
-      word res = 0;
-      for(int k = 0; k < 64; k++) {
-        std::vector<int> vCounts(10), vCounts2(10);
-        for(int j = 0; j < 10; j++) {
-          for(int i = 0; i < n; i++) {
-            vCounts[j] += (v[i + n * j] >> k) & 1;
-            vCounts2[j] += (v2[i + n * j] >> k) & 1;
-          }
-        }
-        if(vCounts != vCounts2) {
-          res |= 1ull << k;
-        }
-      }
-      return res;
-    };
+    switch(pPar->nCustomCondition) {
+    case 0:
+      break;
+    case 1:
+      SetCustomCondition(ClassCountCondition(pPar->nClasses));
+      break;
+    case 2:
+      SetCustomCondition(ClassArgmaxCondition(pPar->nClasses));
+      break;
+    case 3:
+      SetCustomCondition(HammingCondition(pPar->nHammingBudget), true);
+      break;
+    default:
+      assert(0);
+    }
   }
 
   template <typename Ntk>
@@ -1039,6 +1049,7 @@ namespace rrr {
     target = -1;
     fUpdate = false;
     sUpdates.clear();
+    vOriginalPoValues.clear();
     pNtk = pNtk_;
     pNtk->AddCallback(std::bind(&Simulator2<Ntk>::ActionCallback, this, std::placeholders::_1));
     Pattern *pPat = pNtk->GetPattern();
@@ -1196,6 +1207,18 @@ namespace rrr {
 
   /* }}} */
 
+  /* {{{ Custom condition */
+
+  template <typename Ntk>
+  void Simulator2<Ntk>::SetCustomCondition(care_condition Condition, bool fOriginal) {
+    CustomCondition = Condition;
+    fUseCustomCondition = static_cast<bool>(CustomCondition);
+    fCustomOriginal = fUseCustomCondition && fOriginal;
+    target = -1; // careset must be recomputed
+  }
+
+  /* }}} */
+
   /* {{{ Sdc */
   
   template <typename Ntk>